@@ -0,0 +1,68 @@
+#include "bakeManifest.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+//one "hash path" line per asset, the hash in hex
+bool BakeManifest::load(const std::string &filename)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+
+	std::ifstream in(filename.c_str());
+	if (!in.good())
+		return false;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::istringstream fields(line);
+		uint64_t hash;
+		std::string source;
+		if (fields >> std::hex >> hash && std::getline(fields >> std::ws, source))
+			entries[source] = hash;
+	}
+	return true;
+}
+
+bool BakeManifest::save(const std::string &filename)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::string temporary = filename + ".tmp";
+	std::ofstream out(temporary.c_str(), std::ios::out | std::ios::trunc);
+	if (!out.good())
+		return false;
+
+	for (auto it = entries.begin(); it != entries.end(); ++it)
+		out << std::hex << it->second << " " << it->first << "\n";
+	out.close();
+
+	if (!out.good())
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool BakeManifest::isUpToDate(const std::string &source, uint64_t hash, const std::string &output)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = entries.find(source);
+		if (found == entries.end() || found->second != hash)
+			return false;
+	}
+
+	std::ifstream existing(output.c_str(), std::ios::binary);
+	return existing.good();
+}
+
+void BakeManifest::record(const std::string &source, uint64_t hash)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	entries[source] = hash;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//what every asset was last baked from: the hash of its source contents together with the bake settings;
+//an asset whose hash still matches and whose output exists is skipped
+class BakeManifest
+{
+	public:
+		//a missing manifest is an empty one, so everything is baked
+		bool load(const std::string &filename);
+		bool save(const std::string &filename);
+
+		bool isUpToDate(const std::string &source, uint64_t hash, const std::string &output);
+		//safe to call from several threads at once
+		void record(const std::string &source, uint64_t hash);
+
+	private:
+		std::unordered_map<std::string, uint64_t> entries;
+		std::mutex mutex;
+};
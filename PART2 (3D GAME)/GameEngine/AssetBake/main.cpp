@@ -0,0 +1,147 @@
+#include "Model Loading/meshLoaderObj.h"
+#include "Model Loading/mappedFile.h"
+#include "Model Loading/contentHash.h"
+#include "Jobs/jobSystem.h"
+#include "textureBaker.h"
+#include "bakeManifest.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+// assetbake: turns the sources under Resources into what the game maps and uploads at startup
+//   Models/*.obj     -> .meshbin beside them (welded, lods, cache and fetch optimized)
+//   Textures/*       -> .ktx2 beside them (mip chain, BC1/BC3 unless --no-compress, bottom row first)
+//   Skybox/*.png     -> .ktx2 beside them (like textures but not flipped, cubemap faces are top row first)
+// usage: assetbake [resources directory] [--no-compress] [--force]
+
+enum AssetKind { ASSET_MESH, ASSET_TEXTURE, ASSET_CUBEMAP_FACE };
+
+struct BakeAsset {
+    std::string source;
+    std::string output;
+    AssetKind kind;
+};
+
+std::mutex logMutex;                        // keeps lines from different bake jobs apart
+
+// every file in directory with one of the extensions (lowercase, with the dot)
+void collectAssets(const std::string& directory, const std::vector<std::string>& extensions, AssetKind kind, std::vector<BakeAsset>& assets)
+{
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file())
+            continue;
+
+        std::string extension = it->path().extension().string();
+        for (size_t i = 0; i < extension.size(); i++)
+            extension[i] = (char)tolower(extension[i]);
+        if (std::find(extensions.begin(), extensions.end(), extension) == extensions.end())
+            continue;
+
+        BakeAsset asset;
+        asset.source = it->path().generic_string();
+        asset.output = kind == ASSET_MESH ? MeshCache::pathFor(asset.source) : it->path().parent_path().generic_string() + "/" + it->path().stem().string() + ".ktx2";
+        asset.kind = kind;
+        assets.push_back(asset);
+    }
+}
+
+// hash of the source contents, seeded with everything else that changes the output
+bool hashSource(const BakeAsset& asset, bool compress, uint64_t& hash)
+{
+    MappedFile file(asset.source);
+    if (!file.isOpen())
+        return false;
+
+    // meshes are baked with a default loader, the same one the game loads them with
+    uint64_t settings = asset.kind == ASSET_MESH ? MeshLoaderObj().getSettingsHash() : TEXTURE_BAKE_VERSION * 4 + (compress ? 2 : 0) + (asset.kind == ASSET_TEXTURE ? 1 : 0);
+    hash = hashBytes(file.data(), file.size(), settings);
+    return true;
+}
+
+// what the bake printed goes to log, so jobs running at the same time do not interleave their lines
+bool bakeAsset(const BakeAsset& asset, bool compress, std::ostream& log)
+{
+    if (asset.kind == ASSET_MESH) {
+        // the loader writes the .meshbin, packed the way the game uploads it, once it has parsed the obj;
+        // it is told not to reuse an existing one, or --force would leave meshes as they were
+        // without a job system it parses on this thread, the assets themselves are already baked in parallel
+        MeshLoaderObj loader;
+        loader.setReadCache(false);
+        loader.setLog(&log);
+        MeshData data;
+        return loader.loadObjData(asset.source, data);
+    }
+
+    TextureBakeOptions options;
+    options.compress = compress;
+    options.flipVertically = asset.kind == ASSET_TEXTURE;
+    return bakeTexture(asset.source, asset.output, options);
+}
+
+int main(int argc, char** argv)
+{
+    std::string root = "Resources";
+    bool compress = true;
+    bool force = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-compress") == 0)
+            compress = false;
+        else if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else
+            root = argv[i];
+    }
+
+    std::vector<BakeAsset> assets;
+    collectAssets(root + "/Models", { ".obj" }, ASSET_MESH, assets);
+    collectAssets(root + "/Textures", { ".bmp", ".png", ".jpg", ".jpeg", ".tga" }, ASSET_TEXTURE, assets);
+    collectAssets(root + "/Skybox", { ".png" }, ASSET_CUBEMAP_FACE, assets);
+
+    std::string manifestFilename = root + "/assetbake.manifest";
+    BakeManifest manifest;
+    if (!force)
+        manifest.load(manifestFilename);
+
+    // one asset per job, the largest textures and models take long enough that stealing evens things out
+    std::atomic<int> baked(0), skipped(0), failed(0);
+    JobSystem jobs;
+    JobCounter counter;
+    jobs.parallelFor((unsigned int)assets.size(), 1, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            const BakeAsset& asset = assets[i];
+            uint64_t hash;
+            if (!hashSource(asset, compress, hash)) {
+                failed++;
+                continue;
+            }
+
+            if (manifest.isUpToDate(asset.source, hash, asset.output)) {
+                skipped++;
+                continue;
+            }
+
+            std::ostringstream log;
+            bool ok = bakeAsset(asset, compress, log);
+            if (ok)
+                manifest.record(asset.source, hash);
+            (ok ? baked : failed)++;
+
+            std::lock_guard<std::mutex> lock(logMutex);
+            std::cout << (ok ? "Baked:    " : "Failed:   ") << asset.source << " -> " << asset.output << std::endl;
+            std::cout << log.str();
+        }
+    }, counter);
+    jobs.wait(counter);
+
+    if (!manifest.save(manifestFilename))
+        std::cout << "Could not write " << manifestFilename << std::endl;
+
+    std::cout << assets.size() << " assets: " << baked << " baked, " << skipped << " up to date, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
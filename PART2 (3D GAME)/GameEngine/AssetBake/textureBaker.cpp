@@ -0,0 +1,427 @@
+#include "textureBaker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#define STB_IMAGE_IMPLEMENTATION
+#include "Model Loading\stb_image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BAKE_SSE2
+#include <emmintrin.h>
+#endif
+
+//one row of the destination from two rows of the source
+static void downsampleRow(const unsigned char *row0, const unsigned char *row1, int sourceWidth, unsigned char *out, int width)
+{
+	int x = 0;
+
+#if defined(BAKE_SSE2)
+	//four source pixels of both rows, widened to 16 bits, make two destination pixels
+	__m128i zero = _mm_setzero_si128();
+	__m128i rounding = _mm_set1_epi16(2);
+	for (; x + 2 <= width && 2 * x + 4 <= sourceWidth; x += 2)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+		__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+		__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+		sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+		_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, sum));
+	}
+#endif
+
+	for (; x < width; x++)
+	{
+		int x0 = std::min(2 * x, sourceWidth - 1) * 4;
+		int x1 = std::min(2 * x + 1, sourceWidth - 1) * 4;
+		for (int c = 0; c < 4; c++)
+			out[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+	}
+}
+
+void downsample(const BakeImage &source, BakeImage &destination)
+{
+	destination.width = std::max(1, source.width / 2);
+	destination.height = std::max(1, source.height / 2);
+	destination.pixels.resize((size_t)destination.width * destination.height * 4);
+
+	size_t sourceRow = (size_t)source.width * 4;
+	for (int y = 0; y < destination.height; y++)
+	{
+		const unsigned char *row0 = source.pixels.data() + std::min(2 * y, source.height - 1) * sourceRow;
+		const unsigned char *row1 = source.pixels.data() + std::min(2 * y + 1, source.height - 1) * sourceRow;
+		downsampleRow(row0, row1, source.width, destination.pixels.data() + (size_t)y * destination.width * 4, destination.width);
+	}
+}
+
+void buildMipChain(const BakeImage &image, std::vector<BakeImage> &levels)
+{
+	levels.clear();
+	levels.push_back(image);
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		BakeImage next;
+		downsample(levels.back(), next);
+		levels.push_back(std::move(next));
+	}
+}
+
+static uint16_t to565(const float color[3])
+{
+	int r = (int)std::round(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+	int g = (int)std::round(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+	int b = (int)std::round(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void from565(uint16_t value, int color[3])
+{
+	int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+//the 16 pixels of the block at (blockX, blockY), clamped to the image
+static void gatherBlock(const BakeImage &image, int blockX, int blockY, unsigned char block[64])
+{
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 4; x++)
+		{
+			int sx = std::min(blockX * 4 + x, image.width - 1);
+			int sy = std::min(blockY * 4 + y, image.height - 1);
+			memcpy(block + (y * 4 + x) * 4, image.pixels.data() + ((size_t)sy * image.width + sx) * 4, 4);
+		}
+}
+
+//endpoints at the ends of the colors' principal axis (found by power iteration on their covariance), two interpolated colors between
+static void encodeColorBlock(const unsigned char block[64], unsigned char out[8])
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++)
+			mean[c] += block[i * 4 + c] / 16.0f;
+
+	float covariance[3][3] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float d[3] = { block[i * 4] - mean[0], block[i * 4 + 1] - mean[1], block[i * 4 + 2] - mean[2] };
+		for (int a = 0; a < 3; a++)
+			for (int b = 0; b < 3; b++)
+				covariance[a][b] += d[a] * d[b];
+	}
+
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[3];
+		for (int a = 0; a < 3; a++)
+			next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+		float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		if (length < 1e-6f)
+			break;
+		for (int a = 0; a < 3; a++)
+			axis[a] = next[a] / length;
+	}
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = (block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] + (block[i * 4 + 2] - mean[2]) * axis[2];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	float end0[3], end1[3];
+	for (int c = 0; c < 3; c++)
+	{
+		end0[c] = mean[c] + axis[c] * maxT;
+		end1[c] = mean[c] + axis[c] * minT;
+	}
+
+	//color0 > color1 selects the four color mode
+	uint16_t color0 = to565(end0), color1 = to565(end1);
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		from565(color0, palette[0]);
+		from565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, bestDistance = 1 << 30;
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = block[i * 4] - palette[p][0], dg = block[i * 4 + 1] - palette[p][1], db = block[i * 4 + 2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (uint32_t)best << (2 * i);
+		}
+	}
+
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+	for (int i = 0; i < 4; i++)
+		out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+//the block's largest and smallest alpha with six values between, 3 bit indices
+static void encodeAlphaBlock(const unsigned char block[64], unsigned char out[8])
+{
+	int alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+		alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+	}
+
+	uint64_t indices = 0;
+	if (alpha0 > alpha1)
+	{
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 2; p < 8; p++)
+			palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0;
+			for (int p = 1; p < 8; p++)
+				if (std::abs(block[i * 4 + 3] - palette[p]) < std::abs(block[i * 4 + 3] - palette[best]))
+					best = p;
+			indices |= (uint64_t)best << (3 * i);
+		}
+	}
+
+	out[0] = (unsigned char)alpha0;
+	out[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+static void compressBlocks(const BakeImage &image, bool alpha, std::vector<unsigned char> &blocks)
+{
+	int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+	size_t blockSize = alpha ? 16 : 8;
+	blocks.resize((size_t)blocksX * blocksY * blockSize);
+
+	unsigned char block[64];
+	unsigned char *out = blocks.data();
+	for (int y = 0; y < blocksY; y++)
+		for (int x = 0; x < blocksX; x++)
+		{
+			gatherBlock(image, x, y, block);
+			if (alpha)
+			{
+				encodeAlphaBlock(block, out);
+				out += 8;
+			}
+			encodeColorBlock(block, out);
+			out += 8;
+		}
+}
+
+void compressBC1(const BakeImage &image, std::vector<unsigned char> &blocks)
+{
+	compressBlocks(image, false, blocks);
+}
+
+void compressBC3(const BakeImage &image, std::vector<unsigned char> &blocks)
+{
+	compressBlocks(image, true, blocks);
+}
+
+static void put32(std::vector<unsigned char> &out, size_t at, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out[at + i] = (value >> (8 * i)) & 0xFF;
+}
+
+static void put64(std::vector<unsigned char> &out, size_t at, uint64_t value)
+{
+	put32(out, at, (uint32_t)value);
+	put32(out, at + 4, (uint32_t)(value >> 32));
+}
+
+//Vulkan format numbers KTX2 uses, and the matching data format descriptor samples
+enum BakeFormat
+{
+	BAKE_BC1 = 131,     //VK_FORMAT_BC1_RGB_UNORM_BLOCK
+	BAKE_BC3 = 137,     //VK_FORMAT_BC3_UNORM_BLOCK
+	BAKE_RGBA8 = 37     //VK_FORMAT_R8G8B8A8_UNORM
+};
+
+//basic data format descriptor, linear BT.709 colors
+static void writeDescriptor(std::vector<unsigned char> &out, size_t at, BakeFormat format)
+{
+	struct Sample { uint32_t offset, length, channel, upper; };
+	Sample samples[4];
+	int sampleCount, model, blockSize, bytesPerBlock;
+	if (format == BAKE_RGBA8)
+	{
+		Sample rgba[4] = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, 15, 255 } };
+		memcpy(samples, rgba, sizeof(rgba));
+		sampleCount = 4; model = 1; blockSize = 1; bytesPerBlock = 4;
+	}
+	else if (format == BAKE_BC1)
+	{
+		Sample color = { 0, 64, 0, 0xFFFFFFFF };
+		samples[0] = color;
+		sampleCount = 1; model = 128; blockSize = 4; bytesPerBlock = 8;
+	}
+	else
+	{
+		Sample alpha = { 0, 64, 15, 0xFFFFFFFF }, color = { 64, 64, 0, 0xFFFFFFFF };
+		samples[0] = alpha;
+		samples[1] = color;
+		sampleCount = 2; model = 130; blockSize = 4; bytesPerBlock = 16;
+	}
+
+	uint32_t blockBytes = 24 + 16 * sampleCount;
+	put32(out, at, 4 + blockBytes);
+	put32(out, at + 4, 0);
+	put32(out, at + 8, 2 | (blockBytes << 16));
+	put32(out, at + 12, model | (1 << 8) | (1 << 16));
+	put32(out, at + 16, (blockSize - 1) | ((blockSize - 1) << 8));
+	put32(out, at + 20, bytesPerBlock);
+	put32(out, at + 24, 0);
+	for (int i = 0; i < sampleCount; i++)
+	{
+		size_t sample = at + 28 + i * 16;
+		put32(out, sample, samples[i].offset | ((samples[i].length - 1) << 16) | (samples[i].channel << 24));
+		put32(out, sample + 4, 0);
+		put32(out, sample + 8, 0);
+		put32(out, sample + 12, samples[i].upper);
+	}
+}
+
+static size_t descriptorSize(BakeFormat format)
+{
+	return 4 + 24 + 16 * (format == BAKE_RGBA8 ? 4 : format == BAKE_BC1 ? 1 : 2);
+}
+
+//header, level index, descriptor, orientation, then the levels smallest first, each aligned to its block size
+static bool writeKTX2(const std::string &filename, BakeFormat format, int width, int height,
+	const std::vector<std::vector<unsigned char>> &levels, bool bottomUp)
+{
+	static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	static const char orientation[] = "KTXorientation\0ru";
+
+	size_t levelCount = levels.size();
+	size_t descriptorOffset = 80 + levelCount * 24;
+	size_t keyValueOffset = descriptorOffset + descriptorSize(format);
+	size_t keyValueSize = bottomUp ? 4 + ((sizeof(orientation) + 3) & ~(size_t)3) : 0;
+	size_t alignment = format == BAKE_BC3 ? 16 : 8;
+
+	size_t end = keyValueOffset + keyValueSize;
+	std::vector<size_t> offsets(levelCount);
+	for (size_t i = levelCount; i > 0; i--)
+	{
+		end = (end + alignment - 1) / alignment * alignment;
+		offsets[i - 1] = end;
+		end += levels[i - 1].size();
+	}
+
+	std::vector<unsigned char> out(end, 0);
+	memcpy(out.data(), identifier, 12);
+	put32(out, 12, format);
+	put32(out, 16, 1);
+	put32(out, 20, width);
+	put32(out, 24, height);
+	put32(out, 40, (uint32_t)levelCount);
+	put32(out, 36, 1);
+	put32(out, 48, (uint32_t)descriptorOffset);
+	put32(out, 52, (uint32_t)descriptorSize(format));
+	if (bottomUp)
+	{
+		put32(out, 56, (uint32_t)keyValueOffset);
+		put32(out, 60, (uint32_t)keyValueSize);
+		put32(out, keyValueOffset, sizeof(orientation));
+		memcpy(out.data() + keyValueOffset + 4, orientation, sizeof(orientation));
+	}
+
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		put64(out, 80 + i * 24, offsets[i]);
+		put64(out, 80 + i * 24 + 8, levels[i].size());
+		put64(out, 80 + i * 24 + 16, levels[i].size());
+		memcpy(out.data() + offsets[i], levels[i].data(), levels[i].size());
+	}
+	writeDescriptor(out, descriptorOffset, format);
+
+	//write to a temporary file first so a crash never leaves a half written texture behind
+	std::string temporary = filename + ".tmp";
+	std::ofstream file(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.good())
+		return false;
+	file.write((const char*)out.data(), out.size());
+	file.close();
+
+	if (!file.good())
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool bakeTexture(const std::string &source, const std::string &output, const TextureBakeOptions &options)
+{
+	int width, height, channels;
+	unsigned char *data = stbi_load(source.c_str(), &width, &height, &channels, 4);
+	if (!data)
+		return false;
+
+	BakeImage image;
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 4);
+	size_t rowSize = (size_t)width * 4;
+	for (int row = 0; row < height; row++)
+	{
+		int sourceRow = options.flipVertically ? height - 1 - row : row;
+		memcpy(&image.pixels[row * rowSize], data + sourceRow * rowSize, rowSize);
+	}
+	stbi_image_free(data);
+
+	bool opaque = true;
+	for (size_t i = 3; i < image.pixels.size() && opaque; i += 4)
+		opaque = image.pixels[i] == 255;
+
+	std::vector<BakeImage> mips;
+	buildMipChain(image, mips);
+
+	BakeFormat format = !options.compress ? BAKE_RGBA8 : opaque ? BAKE_BC1 : BAKE_BC3;
+	std::vector<std::vector<unsigned char>> levels(mips.size());
+	for (size_t i = 0; i < mips.size(); i++)
+	{
+		if (format == BAKE_BC1)
+			compressBC1(mips[i], levels[i]);
+		else if (format == BAKE_BC3)
+			compressBC3(mips[i], levels[i]);
+		else
+			levels[i] = std::move(mips[i].pixels);
+	}
+
+	return writeKTX2(output, format, width, height, levels, options.flipVertically);
+}
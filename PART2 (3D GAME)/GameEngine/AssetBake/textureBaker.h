@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//bump whenever the output of bakeTexture changes, so every texture is baked again
+#define TEXTURE_BAKE_VERSION 1
+
+//8 bit RGBA pixels, rows tightly packed
+struct BakeImage
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+};
+
+struct TextureBakeOptions
+{
+	bool compress = true;        //BC1, or BC3 when the image has alpha; plain RGBA8 otherwise
+	bool flipVertically = true;  //2D textures are stored bottom row first, cubemap faces as they are
+};
+
+//half the size with a 2x2 box filter, four pixels at a time with SSE2; an odd last row or column is dropped like glGenerateMipmap does
+void downsample(const BakeImage &source, BakeImage &destination);
+//levels[0] is the image itself, the last one is 1x1
+void buildMipChain(const BakeImage &image, std::vector<BakeImage> &levels);
+
+//4x4 blocks, left to right and top to bottom; edge blocks repeat the last row and column
+void compressBC1(const BakeImage &image, std::vector<unsigned char> &blocks);
+void compressBC3(const BakeImage &image, std::vector<unsigned char> &blocks);
+
+//decodes any image stb_image reads and writes a KTX2 with the whole mip chain, which the game loads
+//instead of the source when it sits beside it
+bool bakeTexture(const std::string &source, const std::string &output, const TextureBakeOptions &options);
@@ -0,0 +1,215 @@
+#include "benchmark.h"
+#include "Physics\aabbTree.h"
+#include "Physics\sweep.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+struct TreeBox
+{
+	glm::vec3 boundsMin, boundsMax;
+};
+
+static bool overlaps(const TreeBox &a, const TreeBox &b)
+{
+	return a.boundsMin.x <= b.boundsMax.x && a.boundsMax.x >= b.boundsMin.x &&
+		a.boundsMin.y <= b.boundsMax.y && a.boundsMax.y >= b.boundsMin.y &&
+		a.boundsMin.z <= b.boundsMax.z && a.boundsMax.z >= b.boundsMin.z;
+}
+
+//a planet box somewhere in a cube of the given side, scale 10 to 15 like loadSector makes them
+static TreeBox randomBox(float side, std::mt19937 &random)
+{
+	std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f), scale(10.0f, 15.0f);
+	glm::vec3 center(position(random), position(random), position(random));
+	float halfExtent = scale(random) * 3.0f;
+	TreeBox box = { center - glm::vec3(halfExtent), center + glm::vec3(halfExtent) };
+	return box;
+}
+
+static glm::vec3 randomDirection(std::mt19937 &random)
+{
+	std::normal_distribution<float> normal(0.0f, 1.0f);
+	glm::vec3 direction(normal(random), normal(random), normal(random));
+	return glm::length(direction) > 1e-6f ? glm::normalize(direction) : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+//what the tree should answer, from every box it holds
+static std::vector<unsigned int> scanBoxes(const std::unordered_map<unsigned int, TreeBox> &boxes, const TreeBox &query)
+{
+	std::vector<unsigned int> ids;
+	for (const auto &box : boxes)
+		if (overlaps(box.second, query))
+			ids.push_back(box.first);
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+//nearest box along the ray, as a zero sized box swept over the whole segment
+static bool scanRaycast(const std::unordered_map<unsigned int, TreeBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction,
+	float maxDistance, float &distance)
+{
+	glm::vec3 end = origin + direction * maxDistance;
+	bool found = false;
+	for (const auto &box : boxes)
+	{
+		float timeOfImpact;
+		if (sweepBox(origin, end, glm::vec3(0.0f), box.second.boundsMin, box.second.boundsMax, timeOfImpact) &&
+			(!found || timeOfImpact * maxDistance < distance))
+		{
+			distance = timeOfImpact * maxDistance;
+			found = true;
+		}
+	}
+	return found;
+}
+
+//random inserts, small and large moves and removes, with the tree checked against a scan as it goes
+static int fuzzTree(std::mt19937 &random)
+{
+	const float side = 4000.0f;
+	const float maxDistance = 3000.0f;
+	AABBTree tree(5.0f);
+	std::unordered_map<unsigned int, TreeBox> boxes;
+	std::vector<unsigned int> live;
+	unsigned int nextId = 0;
+
+	std::uniform_int_distribution<int> operation(0, 99);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	bool sameQueries = true, sameRays = true, sameSize = true;
+	int queries = 0, rays = 0, hits = 0;
+
+	for (int step = 0; step < 20000; step++)
+	{
+		int op = operation(random);
+		if (op < 40 || live.size() < 16)
+		{
+			TreeBox box = randomBox(side, random);
+			tree.insert(nextId, box.boundsMin, box.boundsMax);
+			boxes[nextId] = box;
+			live.push_back(nextId++);
+		}
+		else if (op < 85)
+		{
+			//most moves stay inside the fattened leaf, some jump across the world
+			size_t slot = std::uniform_int_distribution<size_t>(0, live.size() - 1)(random);
+			TreeBox &box = boxes[live[slot]];
+			glm::vec3 offset = op < 75 ? glm::vec3(unit(random), unit(random), unit(random)) * 4.0f : randomBox(side, random).boundsMin - box.boundsMin;
+			box.boundsMin += offset;
+			box.boundsMax += offset;
+			tree.move(live[slot], box.boundsMin, box.boundsMax);
+		}
+		else
+		{
+			size_t slot = std::uniform_int_distribution<size_t>(0, live.size() - 1)(random);
+			tree.remove(live[slot]);
+			boxes.erase(live[slot]);
+			live[slot] = live.back();
+			live.pop_back();
+		}
+
+		if (step % 100 != 0)
+			continue;
+
+		sameSize = sameSize && tree.size() == boxes.size();
+
+		TreeBox query = randomBox(side, random);
+		query.boundsMax += glm::vec3(200.0f);
+		std::vector<unsigned int> ids;
+		tree.query(query.boundsMin, query.boundsMax, ids);
+		std::sort(ids.begin(), ids.end());
+		sameQueries = sameQueries && ids == scanBoxes(boxes, query);
+		queries++;
+
+		//the hit box may differ where two boxes are entered at the same distance, the distance may not
+		for (int r = 0; r < 4; r++)
+		{
+			glm::vec3 origin = randomBox(side, random).boundsMin;
+			glm::vec3 direction = randomDirection(random);
+			RayHit hit;
+			float distance = 0.0f;
+			bool treeHit = tree.raycast(origin, direction, maxDistance, hit);
+			bool scanHit = scanRaycast(boxes, origin, direction, maxDistance, distance);
+			sameRays = sameRays && treeHit == scanHit && (!treeHit || fabsf(hit.distance - distance) <= 1e-3f * maxDistance);
+			if (treeHit)
+			{
+				const TreeBox &box = boxes[hit.id];
+				glm::vec3 grownMin = box.boundsMin - glm::vec3(0.01f), grownMax = box.boundsMax + glm::vec3(0.01f);
+				sameRays = sameRays && glm::all(glm::greaterThanEqual(hit.point, grownMin)) && glm::all(glm::lessThanEqual(hit.point, grownMax));
+			}
+			hits += treeHit;
+			rays++;
+		}
+	}
+
+	printf("  fuzz: 20000 operations, %u boxes left, %d queries, %d rays (%d hits)\n", (unsigned int)boxes.size(), queries, rays, hits);
+
+	int failed = 0;
+	failed += !check(sameSize, "the tree holds as many boxes as were inserted and not removed");
+	failed += !check(sameQueries, "box queries find what a scan finds");
+	failed += !check(sameRays, "raycasts hit what sweeping every box finds, at the same distance");
+
+	//emptied again, the tree answers nothing
+	for (unsigned int id : live)
+		tree.remove(id);
+	std::vector<unsigned int> ids;
+	RayHit hit;
+	tree.query(glm::vec3(-side), glm::vec3(side), ids);
+	failed += !check(tree.size() == 0 && ids.empty() && !tree.raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), maxDistance, hit),
+		"an emptied tree finds nothing");
+	return failed;
+}
+
+int benchAabbTree()
+{
+	int failed = 0;
+	std::mt19937 random(18);
+
+	failed += fuzzTree(random);
+
+	//a shot is a 3000 unit ray through the streamed sectors around the ship
+	const unsigned int counts[] = { 100, 1000, 10000 };
+	printf("  %8s  %7s  %12s  %12s\n", "boxes", "height", "tree ray us", "scan ray us");
+	for (unsigned int count : counts)
+	{
+		float side = 1000.0f * cbrtf(count / 14.0f);
+		AABBTree tree(5.0f);
+		std::unordered_map<unsigned int, TreeBox> boxes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			boxes[i] = randomBox(side, random);
+			tree.insert(i, boxes[i].boundsMin, boxes[i].boundsMax);
+		}
+
+		std::vector<glm::vec3> origins, directions;
+		for (int r = 0; r < 1000; r++)
+		{
+			origins.push_back(randomBox(side, random).boundsMin);
+			directions.push_back(randomDirection(random));
+		}
+
+		size_t treeHits = 0, scanHits = 0;
+		double treeMs = timeMs([&]() {
+			treeHits = 0;
+			RayHit hit;
+			for (size_t r = 0; r < origins.size(); r++)
+				treeHits += tree.raycast(origins[r], directions[r], 3000.0f, hit);
+		}, 3);
+		double scanMs = timeMs([&]() {
+			scanHits = 0;
+			float distance;
+			for (size_t r = 0; r < origins.size(); r++)
+				scanHits += scanRaycast(boxes, origins[r], directions[r], 3000.0f, distance);
+		}, 3);
+		printf("  %8u  %7d  %12.3f  %12.2f\n", count, tree.getHeight(), treeMs * 1000.0 / origins.size(), scanMs * 1000.0 / origins.size());
+
+		//balanced by rotations, so the height stays a small multiple of log2
+		std::string name = std::to_string(count) + " boxes";
+		failed += !check(treeHits == scanHits, (name + ": the tree and the scan hit as often").c_str());
+		failed += !check(tree.getHeight() <= 2 * (int)ceil(log2((double)count)), (name + ": the tree stays balanced").c_str());
+	}
+	return failed;
+}
@@ -0,0 +1,33 @@
+#include "benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+double timeMs(const std::function<void()> &f, int repeats)
+{
+	if (repeats > 1)
+		f();
+
+	double best = 1e30;
+	for (int i = 0; i < repeats; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+bool check(bool condition, const char *what)
+{
+	if (!condition)
+		std::cout << "  FAILED: " << what << std::endl;
+	return condition;
+}
+
+std::string temporaryPath(const std::string &name)
+{
+	return (std::filesystem::temp_directory_path() / name).string();
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <functional>
+#include <string>
+
+//shortest of repeats runs of f in milliseconds; with more than one, an untimed run warms the caches first
+double timeMs(const std::function<void()> &f, int repeats = 5);
+
+//prints a failed check, returns the condition so callers can count failures
+bool check(bool condition, const char *what);
+
+//a file in the temp directory
+std::string temporaryPath(const std::string &name);
+//a lat-long sphere of rings x segments quads, written as an obj the way modelling tools export it
+void writeSyntheticObj(const std::string &filename, int rings, int segments);
+
+//each benchmark prints its table and returns how many of its checks failed
+int benchObjParse();
+int benchObjThreads();
+int benchObjCache();
+int benchObjErrors();
+int benchTextureContainers();
+int benchFrustumCull();
+int benchSpatialHash();
+int benchAabbTree();
+int benchSweep();
+int benchJobScaling();
+int benchTransformBatch();
@@ -0,0 +1,81 @@
+#include "benchmark.h"
+#include "Camera\camera.h"
+#include "Camera\frustumCuller.h"
+#include "Jobs\cpuFeatures.h"
+#include <cstdio>
+#include <random>
+#include <string>
+
+static const char *simdNames[] = { "SSE2", "AVX", "AVX2" };
+
+//the test cullSpheres makes, one sphere at a time
+static std::vector<unsigned int> cullReference(const glm::vec4 planes[6], SphereBatch &spheres, unsigned int first, unsigned int last, float radiusScale)
+{
+	std::vector<unsigned int> visible;
+	for (unsigned int i = first; i < last; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < 6; p++)
+			inside = inside && planes[p].x * spheres.x[i] + planes[p].y * spheres.y[i] + planes[p].z * spheres.z[i] + planes[p].w >= -spheres.radius[i] * radiusScale;
+		if (inside)
+			visible.push_back(i);
+	}
+	return visible;
+}
+
+int benchFrustumCull()
+{
+	int failed = 0;
+	SimdLevel detected = getSimdLevel();
+	printf("  processor supports %s\n", simdNames[detected]);
+
+	//spheres scattered around a camera at the origin, about a sixth of them in view; the count is not a
+	//multiple of 8 so every path runs its tail too
+	const unsigned int count = 200003;
+	const float radiusScale = 1.5f;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f), radius(0.5f, 20.0f);
+	SphereBatch spheres;
+	for (unsigned int i = 0; i < count; i++)
+		spheres.push(glm::vec3(position(random), position(random), position(random)), radius(random));
+
+	Camera camera(glm::vec3(0.0f));
+	//this glm takes the field of view in degrees
+	camera.updateFrustum(glm::perspective(90.0f, 16.0f / 9.0f, 0.1f, 400.0f));
+	const glm::vec4 *planes = camera.getFrustumPlanes();
+
+	//whole batch, then ranges that start and end off the 8 and 4 sphere boundaries
+	unsigned int ranges[][2] = { { 0, count }, { 3, 3 }, { 5, 12 }, { 1, 22 }, { 9, 1000 }, { 4001, 4008 } };
+	//the culler has an SSE and an AVX kernel, AVX2 adds nothing it uses
+	for (int level = SIMD_SSE2; level <= detected && level <= SIMD_AVX; level++)
+	{
+		limitSimdLevel((SimdLevel)level);
+		std::vector<unsigned int> visible;
+		CullStats stats;
+
+		for (auto &range : ranges)
+		{
+			visible.clear();
+			cullSpheres(planes, spheres, range[0], range[1], radiusScale, visible, stats);
+			std::string what = std::string(simdNames[level]) + " culls spheres " + std::to_string(range[0]) + " to " + std::to_string(range[1]) + " like the scalar test";
+			failed += !check(visible == cullReference(planes, spheres, range[0], range[1], radiusScale), what.c_str());
+			failed += !check(stats.tested == range[1] - range[0] && stats.visible == visible.size(), "stats count the range");
+		}
+
+		//appends after what the caller already had
+		visible.assign(1, 12345u);
+		cullSpheres(planes, spheres, 0, 64, radiusScale, visible, stats);
+		failed += !check(visible.size() == 1 + stats.visible && visible[0] == 12345u, "visible spheres are appended");
+
+		double ms = timeMs([&]() {
+			visible.clear();
+			cullSpheres(planes, spheres, radiusScale, visible, stats);
+		});
+		printf("  %-5s %u spheres  %7.3f ms  %6.2f ns/sphere  %u visible\n", simdNames[level], count, ms, ms * 1e6 / count, stats.visible);
+	}
+	limitSimdLevel(SIMD_AVX2);
+
+	if (detected < SIMD_AVX)
+		printf("  no AVX on this processor, only the SSE path was checked\n");
+	return failed;
+}
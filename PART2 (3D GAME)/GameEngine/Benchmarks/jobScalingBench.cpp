@@ -0,0 +1,107 @@
+#include "benchmark.h"
+#include "Jobs\jobSystem.h"
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+//a few dozen flops per element, about what preparing a planet instance costs
+static float work(unsigned int i)
+{
+	float x = (float)i * 0.001f;
+	for (int k = 0; k < 8; k++)
+		x = sinf(x) * 0.5f + sqrtf(x * x + 1.0f);
+	return x;
+}
+
+//three stages chained with runAfter, each reading what the one before wrote
+static void runChain(JobSystem &jobs, std::vector<float> &a, std::vector<float> &b, std::vector<float> &c)
+{
+	unsigned int count = (unsigned int)a.size();
+	JobCounter first, second, third;
+	jobs.parallelFor(count, 256, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; i++)
+			a[i] = work(i);
+	}, first);
+	jobs.runAfter(first, [&]() {
+		jobs.parallelFor(count, 256, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int i = begin; i < end; i++)
+				b[i] = a[i] * 2.0f + a[count - 1 - i];
+		}, second);
+	}, &second);
+	jobs.runAfter(second, [&]() {
+		jobs.parallelFor(count, 256, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int i = begin; i < end; i++)
+				c[i] = b[i] - a[i];
+		}, third);
+	}, &third);
+	jobs.wait(third);
+}
+
+int benchJobScaling()
+{
+	int failed = 0;
+	const unsigned int count = 1 << 20;
+
+	//no job system at all, what every thread count is measured against
+	std::vector<float> expectedA(count), expectedB(count), expectedC(count);
+	double serialForMs = timeMs([&]() {
+		for (unsigned int i = 0; i < count; i++)
+			expectedA[i] = work(i);
+	});
+	double serialChainMs = timeMs([&]() {
+		for (unsigned int i = 0; i < count; i++)
+			expectedA[i] = work(i);
+		for (unsigned int i = 0; i < count; i++)
+			expectedB[i] = expectedA[i] * 2.0f + expectedA[count - 1 - i];
+		for (unsigned int i = 0; i < count; i++)
+			expectedC[i] = expectedB[i] - expectedA[i];
+	});
+
+	//a job system always has the main thread and at least one worker; up to twice the cores
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> threadCounts = { 2, 3, 4 };
+	for (unsigned int threads = 8; threads <= cores * 2; threads *= 2)
+		threadCounts.push_back(threads);
+
+	printf("  %u cores, %u elements\n", cores, count);
+	printf("  %7s  %12s  %8s  %12s  %8s  %12s\n", "threads", "parallelFor", "speedup", "runAfter x3", "speedup", "empty job");
+	printf("  %7s  %9.2f ms  %8s  %9.2f ms  %8s\n", "serial", serialForMs, "1.00x", serialChainMs, "1.00x");
+	for (unsigned int threads : threadCounts)
+	{
+		JobSystem jobs(threads - 1);
+		std::vector<float> a(count), b(count), c(count);
+
+		double forMs = timeMs([&]() {
+			JobCounter counter;
+			jobs.parallelFor(count, 64, [&](unsigned int begin, unsigned int end) {
+				for (unsigned int i = begin; i < end; i++)
+					a[i] = work(i);
+			}, counter);
+			jobs.wait(counter);
+		});
+		std::string what = std::to_string(threads) + " threads: parallelFor covers every element once";
+		failed += !check(a == expectedA, what.c_str());
+
+		double chainMs = timeMs([&]() { runChain(jobs, a, b, c); });
+		what = std::to_string(threads) + " threads: runAfter stages see the stage before";
+		failed += !check(b == expectedB && c == expectedC, what.c_str());
+
+		//scheduling cost alone: queue, steal, count down
+		const unsigned int emptyJobs = 100000;
+		std::atomic<unsigned int> ran(0);
+		double emptyMs = timeMs([&]() {
+			JobCounter counter;
+			ran = 0;
+			for (unsigned int i = 0; i < emptyJobs; i++)
+				jobs.run([&ran]() { ran++; }, &counter);
+			jobs.wait(counter);
+		}, 3);
+		what = std::to_string(threads) + " threads: every empty job ran";
+		failed += !check(ran.load() == emptyJobs, what.c_str());
+
+		printf("  %7u  %9.2f ms  %7.2fx  %9.2f ms  %7.2fx  %9.3f us\n", threads, forMs, serialForMs / forMs,
+			chainMs, serialChainMs / chainMs, emptyMs * 1000.0 / emptyJobs);
+	}
+	return failed;
+}
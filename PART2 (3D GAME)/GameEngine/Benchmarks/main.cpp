@@ -0,0 +1,54 @@
+#include "benchmark.h"
+#include <cstring>
+#include <iostream>
+
+// benchmarks: timings and correctness checks for the engine's hot paths, run outside the game
+// usage: benchmarks [name ...]     (every benchmark when no name is given)
+// the exit code is the number of failed checks, so a build step can run it too
+
+struct Benchmark {
+    const char* name;
+    int (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    { "obj-parse", benchObjParse },
+    { "obj-threads", benchObjThreads },
+    { "obj-cache", benchObjCache },
+    { "obj-errors", benchObjErrors },
+    { "texture-containers", benchTextureContainers },
+    { "frustum-cull", benchFrustumCull },
+    { "spatial-hash", benchSpatialHash },
+    { "aabb-tree", benchAabbTree },
+    { "sweep", benchSweep },
+    { "jobs", benchJobScaling },
+    { "transform-batch", benchTransformBatch },
+};
+
+int main(int argc, char** argv)
+{
+    int failed = 0;
+    int ran = 0;
+    for (const Benchmark& benchmark : benchmarks) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+            selected = selected || strcmp(argv[i], benchmark.name) == 0;
+        if (!selected)
+            continue;
+
+        std::cout << "== " << benchmark.name << std::endl;
+        failed += benchmark.run();
+        ran++;
+    }
+
+    if (ran == 0) {
+        std::cout << "usage: benchmarks [name ...], one of:";
+        for (const Benchmark& benchmark : benchmarks)
+            std::cout << " " << benchmark.name;
+        std::cout << std::endl;
+        return 1;
+    }
+
+    std::cout << ran << " benchmarks, " << failed << " failed checks" << std::endl;
+    return failed;
+}
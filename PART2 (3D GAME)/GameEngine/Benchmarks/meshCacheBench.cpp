@@ -0,0 +1,127 @@
+#include "benchmark.h"
+#include "Model Loading\meshLoaderObj.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+//loads the obj with the given lod count, tells whether the .meshbin was used, how many lods came out and how
+//long it took; the mesh is dropped again so the next load may replace the mapped cache file
+static bool loadWithLods(const std::string &filename, unsigned int lodLevels, bool &fromCache, size_t &lods, double &ms)
+{
+	MeshLoaderObj loader;
+	loader.setLodLevels(lodLevels);
+	MeshData data;
+	bool loaded = false;
+	ms = timeMs([&]() { loaded = loader.loadObjData(filename, data); }, 1);
+	fromCache = data.cache.isOpen();
+	lods = data.getLods().size();
+	return loaded;
+}
+
+//what createMesh uploads, copied out so it outlives the MeshData
+struct UploadData
+{
+	std::vector<char> vertices;
+	std::vector<char> indices;
+	VertexQuantization quantization;
+	GLenum indexType;
+};
+
+static UploadData uploadDataOf(const MeshData &data)
+{
+	UploadData upload;
+	const char *vertices = (const char*)data.getVertexData();
+	const char *indices = (const char*)data.getIndexData();
+	upload.vertices.assign(vertices, vertices + (size_t)data.getVertexCount() * vertexStride(data.format));
+	upload.indexType = data.getIndexType();
+	upload.indices.assign(indices, indices + (size_t)data.getIndexCount() * (upload.indexType == GL_UNSIGNED_SHORT ? 2 : 4));
+	upload.quantization = data.quantization;
+	return upload;
+}
+
+//the .meshbin holds exactly what a freshly parsed mesh would upload, in the packed layout
+static int checkPackedCache(const std::string &filename, const std::string &cacheFilename)
+{
+	int failed = 0;
+	std::remove(cacheFilename.c_str());
+
+	MeshLoaderObj loader;
+	UploadData parsed, cached;
+	unsigned int vertexCount = 0, indexCount = 0;
+	{
+		MeshData data;
+		failed += !check(loader.loadObjData(filename, data) && !data.cache.isOpen(), "the obj is parsed into a fresh cache");
+		parsed = uploadDataOf(data);
+		vertexCount = data.getVertexCount();
+		indexCount = data.getIndexCount();
+	}
+	{
+		MeshData data;
+		failed += !check(loader.loadObjData(filename, data) && data.cache.isOpen(), "the fresh cache is mapped");
+		failed += !check(data.format == VERTEX_SNORM16, "the cached mesh keeps the loader's vertex format");
+		cached = uploadDataOf(data);
+	}
+
+	failed += !check(parsed.indexType == GL_UNSIGNED_SHORT && cached.indexType == GL_UNSIGNED_SHORT, "the indices are cached as 16 bits");
+	failed += !check(parsed.vertices == cached.vertices && parsed.indices == cached.indices &&
+		memcmp(&parsed.quantization, &cached.quantization, sizeof(VertexQuantization)) == 0, "the cache round trips the upload data");
+
+	//the old layout stored 32 byte float vertices and 32 bit indices
+	size_t size = std::filesystem::file_size(cacheFilename);
+	size_t floatSize = sizeof(MeshCacheHeader) + (size_t)vertexCount * sizeof(Vertex) + (size_t)indexCount * sizeof(int);
+	printf("  .meshbin %zu KB, %zu KB with float vertices and 32 bit indices\n", size / 1024, floatSize / 1024);
+	failed += !check(size < floatSize * 6 / 10, "the packed cache is well under the float one");
+
+	//a loader with another vertex format must not map a cache packed for this one
+	MeshLoaderObj floatLoader;
+	floatLoader.setVertexFormat(VERTEX_FLOAT);
+	MeshData floats;
+	failed += !check(floatLoader.loadObjData(filename, floats) && !floats.cache.isOpen() && floats.format == VERTEX_FLOAT, "another vertex format rebuilds the cache");
+
+	return failed;
+}
+
+int benchObjCache()
+{
+	int failed = 0;
+	std::string filename = temporaryPath("benchmark_cache.obj");
+	std::string cacheFilename = MeshCache::pathFor(filename);
+	std::remove(cacheFilename.c_str());
+	writeSyntheticObj(filename, 128, 256);
+
+	bool fromCache;
+	size_t lods;
+	double parseMs, cachedMs, otherLodsMs;
+	failed += !check(loadWithLods(filename, 5, fromCache, lods, parseMs) && !fromCache, "the first load parses the obj");
+	failed += !check(loadWithLods(filename, 5, fromCache, lods, cachedMs) && fromCache, "the second load maps the .meshbin");
+	failed += !check(lods == 5, "the cached mesh has its 5 lods");
+
+	//a setting that changes the output must not be answered from a cache built without it
+	failed += !check(loadWithLods(filename, 3, fromCache, lods, otherLodsMs) && !fromCache, "other lod levels rebuild the cache");
+	failed += !check(lods == 3, "the rebuilt mesh has 3 lods");
+	failed += !check(loadWithLods(filename, 3, fromCache, lods, otherLodsMs) && fromCache && lods == 3, "the rebuilt cache is used after that");
+
+	printf("  parse, weld, lods and reorder  %8.2f ms\n", parseMs);
+	printf("  mapped .meshbin                %8.2f ms\n", cachedMs);
+
+	failed += checkPackedCache(filename, cacheFilename);
+
+	//assetbake's loader: an up to date cache is parsed over anyway, and what it prints goes to its own log
+	failed += !check(loadWithLods(filename, 5, fromCache, lods, cachedMs) && loadWithLods(filename, 5, fromCache, lods, cachedMs) && fromCache,
+		"the default loader's cache is up to date");
+	MeshLoaderObj baker;
+	baker.setReadCache(false);
+	std::ostringstream log;
+	baker.setLog(&log);
+	{
+		MeshData baked;
+		failed += !check(baker.loadObjData(filename, baked) && !baked.cache.isOpen(), "a loader that skips the cache parses the obj again");
+	}
+	failed += !check(log.str().find("face corners welded") != std::string::npos, "its output goes to the log it was given");
+	failed += !check(loadWithLods(filename, 5, fromCache, lods, cachedMs) && fromCache, "the cache it wrote is used by the default loader");
+
+	std::remove(cacheFilename.c_str());
+	std::remove(filename.c_str());
+	return failed;
+}
@@ -0,0 +1,343 @@
+#include "benchmark.h"
+#include "Model Loading\meshLoaderObj.h"
+#include "Model Loading\mappedFile.h"
+#include "Jobs\jobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+//a lat-long sphere of quads with one position, texcoord and normal per grid point; every 7th face uses
+//negative indices, lines end in CRLF and some carry comments, like the files exported by modelling tools
+void writeSyntheticObj(const std::string &filename, int rings, int segments)
+{
+	FILE *file;
+	if (fopen_s(&file, filename.c_str(), "wb") != 0)
+		return;
+
+	fprintf(file, "# synthetic sphere, %d x %d quads\r\n", rings, segments);
+	for (int r = 0; r <= rings; r++)
+		for (int s = 0; s <= segments; s++)
+		{
+			float theta = 3.14159265f * r / rings;
+			float phi = 6.28318531f * s / segments;
+			float x = sinf(theta) * cosf(phi), y = cosf(theta), z = sinf(theta) * sinf(phi);
+			fprintf(file, "v %.6f %.6f %.6f\r\nvt %.6f %.6f\r\nvn %.6f %.6f %.6f\r\n", x * 10.0f, y * 10.0f, z * 10.0f,
+				(float)s / segments, (float)r / rings, x, y, z);
+		}
+
+	int written = 0;
+	int total = (rings + 1) * (segments + 1);
+	for (int r = 0; r < rings; r++)
+		for (int s = 0; s < segments; s++)
+		{
+			int corners[4] = { r * (segments + 1) + s + 1, (r + 1) * (segments + 1) + s + 1, (r + 1) * (segments + 1) + s + 2, r * (segments + 1) + s + 2 };
+			fprintf(file, "f");
+			for (int c = 0; c < 4; c++)
+			{
+				int index = written % 7 == 0 ? corners[c] - total - 1 : corners[c];
+				fprintf(file, " %d/%d/%d", index, index, index);
+			}
+			fprintf(file, written % 5 == 0 ? " # quad\r\n" : "\r\n");
+			written++;
+		}
+
+	fclose(file);
+}
+
+//the loader as it was before it parsed the file in place: getline, stringstream tokens, one vertex per corner
+static float baselineFloat(const std::string &source)
+{
+	std::stringstream ss(source.c_str());
+	float result = 0.0f;
+	ss >> result;
+	return result;
+}
+
+static int baselineInt(const std::string &source)
+{
+	std::stringstream ss(source.c_str());
+	int result = 0;
+	ss >> result;
+	return result;
+}
+
+static void baselineTokenize(const std::string &source, std::vector<std::string> &tokens)
+{
+	tokens.clear();
+	std::string aux = source;
+	for (unsigned int i = 0; i < aux.size(); i++) if (aux[i] == '\t' || aux[i] == '\n') aux[i] = ' ';
+	std::stringstream ss(aux, std::ios::in);
+	while (ss.good()) {
+		std::string s;
+		ss >> s;
+		if (s.size() > 0) tokens.push_back(s);
+	}
+}
+
+static void baselineFaceTokenize(const std::string &source, std::vector<std::string> &tokens)
+{
+	std::string aux = source;
+	for (unsigned int i = 0; i < aux.size(); i++) if (aux[i] == '\\' || aux[i] == '/') aux[i] = ' ';
+	baselineTokenize(aux, tokens);
+}
+
+static int baselineIndex(int index, size_t count)
+{
+	return index > 0 ? index - 1 : (int)count + index;
+}
+
+//only the position/texcoord/normal face format, which is all writeSyntheticObj produces
+static void parseObjBaseline(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices)
+{
+	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+	std::string line;
+	std::vector<std::string> tokens, facetokens;
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> texcoords;
+
+	while (std::getline(file, line))
+	{
+		baselineTokenize(line, tokens);
+		if (tokens.size() == 0 || tokens[0].at(0) == '#')
+			continue;
+
+		if (tokens.size() > 3 && tokens[0] == "v")
+			positions.push_back(glm::vec3(baselineFloat(tokens[1]), baselineFloat(tokens[2]), baselineFloat(tokens[3])));
+		if (tokens.size() > 3 && tokens[0] == "vn")
+			normals.push_back(glm::vec3(baselineFloat(tokens[1]), baselineFloat(tokens[2]), baselineFloat(tokens[3])));
+		if (tokens.size() > 2 && tokens[0] == "vt")
+			texcoords.push_back(glm::vec2(baselineFloat(tokens[1]), baselineFloat(tokens[2])));
+
+		if (tokens.size() >= 4 && tokens[0] == "f")
+		{
+			int first = -1;
+			for (unsigned int num_token = 1; num_token < tokens.size(); num_token++)
+			{
+				if (tokens[num_token].at(0) == '#') break;
+				baselineFaceTokenize(tokens[num_token], facetokens);
+
+				const glm::vec3 &p = positions[baselineIndex(baselineInt(facetokens[0]), positions.size())];
+				const glm::vec2 &t = texcoords[baselineIndex(baselineInt(facetokens[1]), texcoords.size())];
+				const glm::vec3 &n = normals[baselineIndex(baselineInt(facetokens[2]), normals.size())];
+				vertices.push_back(Vertex(p.x, p.y, p.z, n.x, n.y, n.z, t.x, t.y));
+
+				if (num_token < 4)
+				{
+					if (num_token == 1)
+						first = vertices.size() - 1;
+					indices.push_back(vertices.size() - 1);
+				}
+				else
+				{
+					indices.push_back(first);
+					indices.push_back(vertices.size() - 2);
+					indices.push_back(vertices.size() - 1);
+				}
+			}
+		}
+	}
+}
+
+//the same triangles with the same corners, however the vertices were welded
+static bool sameTriangles(const std::vector<Vertex> &expectedVertices, const std::vector<int> &expectedIndices,
+	const std::vector<Vertex> &vertices, const std::vector<int> &indices)
+{
+	if (expectedIndices.size() != indices.size())
+		return false;
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		const Vertex &a = expectedVertices[expectedIndices[i]];
+		const Vertex &b = vertices[indices[i]];
+		if (a.pos != b.pos || a.normals != b.normals || a.textureCoords != b.textureCoords)
+			return false;
+	}
+	return true;
+}
+
+static std::string syntheticObjPath()
+{
+	return temporaryPath("benchmark_synthetic.obj");
+}
+
+int benchObjParse()
+{
+	int failed = 0;
+	std::string filename = syntheticObjPath();
+	writeSyntheticObj(filename, 384, 768);
+
+	MappedFile file(filename);
+	if (!check(file.isOpen(), "synthetic obj written"))
+		return 1;
+	double megabytes = file.size() / (1024.0 * 1024.0);
+
+	std::vector<Vertex> baselineVertices, vertices;
+	std::vector<int> baselineIndices, indices;
+	double baselineMs = timeMs([&]() {
+		baselineVertices.clear();
+		baselineIndices.clear();
+		parseObjBaseline(filename, baselineVertices, baselineIndices);
+	}, 1);
+
+	//no job system, so this compares the parsers and not the chunking
+	MeshLoaderObj loader;
+	double mappedMs = timeMs([&]() {
+		vertices.clear();
+		indices.clear();
+		loader.parseObj(file.data(), file.data() + file.size(), vertices, indices);
+	}, 3);
+
+	printf("  %.1f MB, %u triangles\n", megabytes, (unsigned int)indices.size() / 3);
+	printf("  stringstream baseline  %9.1f ms  %7.1f MB/s\n", baselineMs, megabytes * 1000.0 / baselineMs);
+	printf("  mapped + from_chars    %9.1f ms  %7.1f MB/s  (%.1fx)\n", mappedMs, megabytes * 1000.0 / mappedMs, baselineMs / mappedMs);
+
+	failed += !check(!indices.empty(), "the mapped parser read the faces");
+	failed += !check(sameTriangles(baselineVertices, baselineIndices, vertices, indices), "both parsers give the same triangles");
+	failed += !check(vertices.size() < baselineVertices.size(), "shared corners are welded");
+
+	file.close();
+	std::remove(filename.c_str());
+	return failed;
+}
+
+static bool sameMesh(const std::vector<Vertex> &expectedVertices, const std::vector<int> &expectedIndices,
+	const std::vector<Vertex> &vertices, const std::vector<int> &indices)
+{
+	return expectedVertices.size() == vertices.size() && expectedIndices == indices &&
+		memcmp(expectedVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0;
+}
+
+int benchObjThreads()
+{
+	int failed = 0;
+	std::string filename = syntheticObjPath();
+	writeSyntheticObj(filename, 384, 768);
+
+	MappedFile file(filename);
+	if (!check(file.isOpen(), "synthetic obj written"))
+		return 1;
+
+	//up to twice the cores, and a few odd counts so chunk edges land in the middle of lines
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> threadCounts = { 1, 2, 3, 4, 7 };
+	for (unsigned int threads = 8; threads <= cores * 2; threads *= 2)
+		threadCounts.push_back(threads);
+
+	std::vector<Vertex> singleVertices;
+	std::vector<int> singleIndices;
+	double singleMs = 0.0;
+	printf("  %u cores\n", cores);
+	for (size_t i = 0; i < threadCounts.size(); i++)
+	{
+		//the calling thread joins the workers while it waits, so n threads need n - 1 workers
+		std::unique_ptr<JobSystem> jobs;
+		MeshLoaderObj loader;
+		if (threadCounts[i] > 1)
+		{
+			jobs.reset(new JobSystem(threadCounts[i] - 1));
+			loader.setJobSystem(jobs.get());
+		}
+		loader.setParseChunks(threadCounts[i]);
+
+		std::vector<Vertex> vertices;
+		std::vector<int> indices;
+		double ms = timeMs([&]() {
+			vertices.clear();
+			indices.clear();
+			loader.parseObj(file.data(), file.data() + file.size(), vertices, indices);
+		}, 2);
+
+		if (i == 0)
+		{
+			singleMs = ms;
+			singleVertices = vertices;
+			singleIndices = indices;
+		}
+		printf("  %2u threads  %8.1f ms  speedup %.2fx\n", threadCounts[i], ms, singleMs / ms);
+
+		std::string what = std::to_string(threadCounts[i]) + " threads give the single threaded mesh";
+		failed += !check(sameMesh(singleVertices, singleIndices, vertices, indices), what.c_str());
+	}
+
+	file.close();
+	std::remove(filename.c_str());
+	return failed;
+}
+
+//parses text as an obj, returning whether it was accepted and how many triangles it gave
+static bool parseText(const std::string &text, unsigned int chunks, size_t &triangles)
+{
+	MeshLoaderObj loader;
+	loader.setParseChunks(chunks);
+
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+	bool parsed = loader.parseObj(text.data(), text.data() + text.size(), vertices, indices);
+	triangles = indices.size() / 3;
+	return parsed;
+}
+
+int benchObjErrors()
+{
+	int failed = 0;
+	const std::string triangle = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n";
+
+	struct Case
+	{
+		const char *faces;
+		bool accepted;
+		const char *what;
+	};
+	const Case cases[] = {
+		{ "f 1 2 3\n", true, "a valid face is read" },
+		{ "f -3 -2 -1\n", true, "negative indices count back from the face" },
+		{ "f 1/1/1 2/1/1 3/1/1\n", true, "shared texcoords and normals are read" },
+		{ "f 0 1 2\n", false, "index 0 is rejected" },
+		{ "f 1 2 5\n", false, "a position past the end is rejected" },
+		{ "f -4 -2 -1\n", false, "a negative index before the start is rejected" },
+		{ "f 1/1 2/2 3/1\n", false, "a texcoord past the end is rejected" },
+		{ "f 1//1 2//1 3//2\n", false, "a normal past the end is rejected" },
+		{ "f 1 2 3\nf 1 2 2147483647\n", false, "a huge index is rejected" },
+	};
+
+	for (const Case &test : cases)
+	{
+		size_t triangles = 0;
+		bool accepted = parseText(triangle + test.faces, 1, triangles);
+		failed += !check(accepted == test.accepted && (accepted ? triangles == 1 : triangles == 0), test.what);
+	}
+
+	//a bad face in a later chunk still fails the whole file
+	std::string large;
+	for (int i = 0; i < 20000; i++)
+		large += triangle + "f -3 -2 -1\n";
+	size_t triangles = 0;
+	failed += !check(parseText(large, 4, triangles) && triangles == 20000, "a chunked file is read");
+	failed += !check(!parseText(large + "f 1 2 999999\n", 4, triangles) && triangles == 0, "a bad face in the last chunk is rejected");
+
+	//loadObjData returns false instead of throwing, and does not leave a cache behind
+	std::string filename = temporaryPath("benchmark_errors.obj");
+	std::string cacheFilename = MeshCache::pathFor(filename);
+	std::remove(cacheFilename.c_str());
+	{
+		std::ofstream file(filename, std::ios::binary);
+		file << triangle << "f 1 2 5\n";
+	}
+	MeshLoaderObj loader;
+	MeshData data;
+	failed += !check(!loader.loadObjData(filename, data), "loading a file with a bad face fails");
+	failed += !check(!std::filesystem::exists(cacheFilename), "no cache is written for it");
+	std::remove(filename.c_str());
+
+	MeshData missing;
+	failed += !check(!loader.loadObjData(filename, missing), "loading a missing file fails");
+
+	return failed;
+}
@@ -0,0 +1,207 @@
+#include "benchmark.h"
+#include "Physics\spatialHash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+struct Box
+{
+	glm::vec3 boundsMin, boundsMax;
+};
+
+static bool overlaps(const Box &a, const Box &b)
+{
+	return a.boundsMin.x <= b.boundsMax.x && a.boundsMax.x >= b.boundsMin.x &&
+		a.boundsMin.y <= b.boundsMax.y && a.boundsMax.y >= b.boundsMin.y &&
+		a.boundsMin.z <= b.boundsMax.z && a.boundsMax.z >= b.boundsMin.z;
+}
+
+//planet boxes as loadSector makes them: scale 10 to 15, three times that either side of the center
+static std::vector<Box> randomPlanets(unsigned int count, float side, std::mt19937 &random)
+{
+	std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f), scale(10.0f, 15.0f);
+	std::vector<Box> planets(count);
+	for (Box &planet : planets)
+	{
+		glm::vec3 center(position(random), position(random), position(random));
+		float halfExtent = scale(random) * 3.0f;
+		planet.boundsMin = center - glm::vec3(halfExtent);
+		planet.boundsMax = center + glm::vec3(halfExtent);
+	}
+	return planets;
+}
+
+//the ship's box swept over one 120 Hz step, up to the 5000 units per second top speed
+static std::vector<Box> randomQueries(unsigned int count, float side, std::mt19937 &random)
+{
+	std::uniform_real_distribution<float> position(-side * 0.5f, side * 0.5f), sweep(0.0f, 42.0f);
+	std::vector<Box> queries(count);
+	for (Box &query : queries)
+	{
+		glm::vec3 start(position(random), position(random), position(random));
+		query.boundsMin = start - glm::vec3(1.0f);
+		query.boundsMax = start + glm::vec3(1.0f + sweep(random), 1.0f, 1.0f);
+	}
+	return queries;
+}
+
+static std::vector<unsigned int> scanPlanets(const std::vector<Box> &planets, const std::vector<bool> &inserted, const Box &query)
+{
+	std::vector<unsigned int> ids;
+	for (unsigned int i = 0; i < planets.size(); i++)
+		if (inserted[i] && overlaps(planets[i], query))
+			ids.push_back(i);
+	return ids;
+}
+
+static bool sameIds(std::vector<unsigned int> ids, const std::vector<unsigned int> &sortedExpected)
+{
+	std::sort(ids.begin(), ids.end());
+	return ids == sortedExpected;
+}
+
+struct HashTiming
+{
+	double hashUs;
+	double scanUs;
+	double hitsPerQuery;
+	double candidatesPerQuery;
+};
+
+//per query times of the hash and of a linear scan over the same boxes
+static HashTiming timeQueries(SpatialHash &grid, const std::vector<Box> &planets, const std::vector<Box> &queries, float cellSize)
+{
+	HashTiming timing;
+	std::vector<unsigned int> ids;
+	size_t hits = 0;
+	double ms = timeMs([&]() {
+		hits = 0;
+		for (const Box &query : queries)
+		{
+			ids.clear();
+			grid.query(query.boundsMin, query.boundsMax, ids);
+			hits += ids.size();
+		}
+	}, 3);
+	timing.hashUs = ms * 1000.0 / queries.size();
+	timing.hitsPerQuery = (double)hits / queries.size();
+
+	//a scan gets slow fast, a few hundred queries are enough to time it
+	size_t scanned = std::min<size_t>(queries.size(), 2000000 / planets.size() + 1);
+	size_t scanHits = 0;
+	ms = timeMs([&]() {
+		for (size_t q = 0; q < scanned; q++)
+			for (const Box &planet : planets)
+				scanHits += overlaps(planet, queries[q]);
+	}, 3);
+	timing.scanUs = ms * 1000.0 / scanned;
+
+	//entries filed in the cells a query visits, hit or not; what the hash's cost follows
+	size_t candidates = 0;
+	for (const Box &query : queries)
+	{
+		int lowX = (int)floorf(query.boundsMin.x / cellSize), highX = (int)floorf(query.boundsMax.x / cellSize);
+		int lowY = (int)floorf(query.boundsMin.y / cellSize), highY = (int)floorf(query.boundsMax.y / cellSize);
+		int lowZ = (int)floorf(query.boundsMin.z / cellSize), highZ = (int)floorf(query.boundsMax.z / cellSize);
+		for (const Box &planet : planets)
+			if ((int)floorf(planet.boundsMin.x / cellSize) <= highX && (int)floorf(planet.boundsMax.x / cellSize) >= lowX &&
+				(int)floorf(planet.boundsMin.y / cellSize) <= highY && (int)floorf(planet.boundsMax.y / cellSize) >= lowY &&
+				(int)floorf(planet.boundsMin.z / cellSize) <= highZ && (int)floorf(planet.boundsMax.z / cellSize) >= lowZ)
+				candidates++;
+		if (&query - queries.data() == 999)
+			break;
+	}
+	timing.candidatesPerQuery = candidates / 1000.0;
+	return timing;
+}
+
+//the hash and a scan agree on every checked query, with all planets in and after removing every other one
+static int checkAgainstScan(SpatialHash &grid, const std::vector<Box> &planets, const std::vector<Box> &queries, const std::string &name)
+{
+	int failed = 0;
+	std::vector<bool> inserted(planets.size(), true);
+	std::vector<unsigned int> ids;
+	bool same = true;
+	for (size_t q = 0; q < 200 && q < queries.size(); q++)
+	{
+		ids.clear();
+		grid.query(queries[q].boundsMin, queries[q].boundsMax, ids);
+		same = same && sameIds(ids, scanPlanets(planets, inserted, queries[q]));
+	}
+	failed += !check(same, (name + ": queries find what a scan finds").c_str());
+
+	for (unsigned int i = 0; i < planets.size(); i += 2)
+	{
+		grid.remove(i);
+		inserted[i] = false;
+	}
+	same = grid.size() == planets.size() / 2;
+	for (size_t q = 0; q < 200 && q < queries.size(); q++)
+	{
+		ids.clear();
+		grid.query(queries[q].boundsMin, queries[q].boundsMax, ids);
+		same = same && sameIds(ids, scanPlanets(planets, inserted, queries[q]));
+	}
+	failed += !check(same, (name + ": removed planets are not found").c_str());
+
+	for (unsigned int i = 0; i < planets.size(); i += 2)
+		grid.insert(i, planets[i].boundsMin, planets[i].boundsMax);
+	return failed;
+}
+
+int benchSpatialHash()
+{
+	int failed = 0;
+	const float cellSize = 128.0f;
+	const unsigned int counts[] = { 90, 1000, 10000, 100000 };
+	std::mt19937 random(12);
+
+	//the streamed world: 14 to 28 planets per 1000 unit sector, so more planets means more space
+	//a fixed 2000 unit cube: more planets means every cell, and every query, gets more crowded
+	for (int fixedVolume = 0; fixedVolume < 2; fixedVolume++)
+	{
+		printf(fixedVolume ? "  fixed 2000^3 volume, %.0f unit cells\n" : "  constant density, 14 planets per 1000^3, %.0f unit cells\n", cellSize);
+		printf("  %8s  %10s  %10s  %11s  %11s\n", "planets", "hash us", "scan us", "hits/query", "candidates");
+		double firstUs = 0.0;
+		for (unsigned int count : counts)
+		{
+			float side = fixedVolume ? 2000.0f : 1000.0f * cbrtf(count / 14.0f);
+			std::vector<Box> planets = randomPlanets(count, side, random);
+			std::vector<Box> queries = randomQueries(20000, side, random);
+
+			SpatialHash grid(cellSize);
+			for (unsigned int i = 0; i < count; i++)
+				grid.insert(i, planets[i].boundsMin, planets[i].boundsMax);
+
+			HashTiming timing = timeQueries(grid, planets, queries, cellSize);
+			if (count == counts[0])
+				firstUs = timing.hashUs;
+			printf("  %8u  %10.3f  %10.2f  %11.3f  %11.2f\n", count, timing.hashUs, timing.scanUs, timing.hitsPerQuery, timing.candidatesPerQuery);
+
+			std::string name = std::to_string(count) + (fixedVolume ? " planets in a fixed volume" : " planets at constant density");
+			failed += checkAgainstScan(grid, planets, queries, name);
+			if (!fixedVolume && count == counts[3])
+				failed += !check(timing.hashUs < firstUs * 10.0, "at constant density a query costs about the same at any count");
+		}
+	}
+
+	//cells smaller than a box file it many times over, larger ones hand a query more boxes that miss it
+	printf("  100000 planets in the fixed volume by cell size\n");
+	std::vector<Box> planets = randomPlanets(100000, 2000.0f, random);
+	std::vector<Box> queries = randomQueries(20000, 2000.0f, random);
+	const float cellSizes[] = { 32.0f, 64.0f, 128.0f, 256.0f };
+	for (float size : cellSizes)
+	{
+		SpatialHash grid(size);
+		double insertMs = timeMs([&]() {
+			grid.clear();
+			for (unsigned int i = 0; i < planets.size(); i++)
+				grid.insert(i, planets[i].boundsMin, planets[i].boundsMax);
+		}, 1);
+		HashTiming timing = timeQueries(grid, planets, queries, size);
+		printf("  %5.0f unit cells  insert all %8.1f ms  query %7.3f us  candidates %8.2f\n", size, insertMs, timing.hashUs, timing.candidatesPerQuery);
+	}
+	return failed;
+}
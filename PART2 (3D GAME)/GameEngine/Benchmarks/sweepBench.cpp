@@ -0,0 +1,161 @@
+#include "benchmark.h"
+#include "Physics\sweep.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+//positions along the motion the brute force tests look at
+static const int sampleCount = 2048;
+
+static bool boxesOverlap(const glm::vec3 &center, const glm::vec3 &halfExtents, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float slack)
+{
+	glm::vec3 low = center - halfExtents, high = center + halfExtents;
+	return low.x <= boundsMax.x + slack && high.x >= boundsMin.x - slack &&
+		low.y <= boundsMax.y + slack && high.y >= boundsMin.y - slack &&
+		low.z <= boundsMax.z + slack && high.z >= boundsMin.z - slack;
+}
+
+static bool spheresOverlap(const glm::vec3 &center, float radius, const glm::vec3 &otherCenter, float otherRadius, float slack)
+{
+	return glm::length(center - otherCenter) <= radius + otherRadius + slack;
+}
+
+//first sampled fraction at which the boxes overlap, shrunk by slack so grazing contacts do not count
+static bool sampleBox(const glm::vec3 &start, const glm::vec3 &end, const glm::vec3 &halfExtents,
+	const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float slack, float &first)
+{
+	for (int i = 0; i <= sampleCount; i++)
+	{
+		float t = (float)i / sampleCount;
+		if (boxesOverlap(start + (end - start) * t, halfExtents, boundsMin, boundsMax, -slack))
+		{
+			first = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool sampleSphere(const glm::vec3 &start, const glm::vec3 &end, float radius, const glm::vec3 &center, float otherRadius, float slack, float &first)
+{
+	for (int i = 0; i <= sampleCount; i++)
+	{
+		float t = (float)i / sampleCount;
+		if (spheresOverlap(start + (end - start) * t, radius, center, otherRadius, -slack))
+		{
+			first = t;
+			return true;
+		}
+	}
+	return false;
+}
+
+//the ship moving up to one 120 Hz step at top speed past planet sized targets, often starting close to them
+struct SweepCase
+{
+	glm::vec3 start, end;
+	glm::vec3 halfExtents;
+	float radius;
+	glm::vec3 center;
+	glm::vec3 targetHalfExtents;
+	float targetRadius;
+};
+
+static std::vector<SweepCase> randomCases(unsigned int count, std::mt19937 &random)
+{
+	std::uniform_real_distribution<float> position(-80.0f, 80.0f), motion(-120.0f, 120.0f), size(0.5f, 4.0f), target(5.0f, 45.0f);
+	std::vector<SweepCase> cases(count);
+	for (SweepCase &test : cases)
+	{
+		test.start = glm::vec3(position(random), position(random), position(random));
+		test.end = test.start + glm::vec3(motion(random), motion(random), motion(random));
+		test.halfExtents = glm::vec3(size(random), size(random), size(random));
+		test.radius = size(random);
+		test.center = glm::vec3(0.0f);
+		test.targetHalfExtents = glm::vec3(target(random), target(random), target(random));
+		test.targetRadius = target(random);
+	}
+	return cases;
+}
+
+int benchSweep()
+{
+	int failed = 0;
+	std::mt19937 random(20);
+	std::vector<SweepCase> cases = randomCases(20000, random);
+
+	//whatever sampling sees, the sweep sees no later; where the sweep reports contact the shapes do touch
+	const float slack = 1e-3f;
+	bool boxesAgree = true, spheresAgree = true;
+	int boxHits = 0, sphereHits = 0, boxStartsInside = 0, sphereStartsInside = 0;
+	for (const SweepCase &test : cases)
+	{
+		glm::vec3 boundsMin = test.center - test.targetHalfExtents, boundsMax = test.center + test.targetHalfExtents;
+		float sampled = 0.0f, timeOfImpact = -1.0f;
+		bool sampledHit = sampleBox(test.start, test.end, test.halfExtents, boundsMin, boundsMax, slack, sampled);
+		bool swept = sweepBox(test.start, test.end, test.halfExtents, boundsMin, boundsMax, timeOfImpact);
+		if (sampledHit)
+			boxesAgree = boxesAgree && swept && timeOfImpact <= sampled + 1e-4f;
+		if (swept)
+		{
+			glm::vec3 contact = test.start + (test.end - test.start) * timeOfImpact;
+			boxesAgree = boxesAgree && timeOfImpact >= 0.0f && timeOfImpact <= 1.0f && boxesOverlap(contact, test.halfExtents, boundsMin, boundsMax, slack);
+			boxHits++;
+			boxStartsInside += timeOfImpact == 0.0f;
+		}
+
+		sampled = 0.0f;
+		timeOfImpact = -1.0f;
+		sampledHit = sampleSphere(test.start, test.end, test.radius, test.center, test.targetRadius, slack, sampled);
+		swept = sweepSphere(test.start, test.end, test.radius, test.center, test.targetRadius, timeOfImpact);
+		if (sampledHit)
+			spheresAgree = spheresAgree && swept && timeOfImpact <= sampled + 1e-4f;
+		if (swept)
+		{
+			glm::vec3 contact = test.start + (test.end - test.start) * timeOfImpact;
+			spheresAgree = spheresAgree && timeOfImpact >= 0.0f && timeOfImpact <= 1.0f && spheresOverlap(contact, test.radius, test.center, test.targetRadius, slack);
+			sphereHits++;
+			sphereStartsInside += timeOfImpact == 0.0f;
+		}
+	}
+	printf("  %u random sweeps: %d box hits (%d starting inside), %d sphere hits (%d starting inside)\n",
+		(unsigned int)cases.size(), boxHits, boxStartsInside, sphereHits, sphereStartsInside);
+	failed += !check(boxesAgree, "sweepBox finds every sampled contact, no later, and only real ones");
+	failed += !check(spheresAgree, "sweepSphere finds every sampled contact, no later, and only real ones");
+
+	//the reason for sweeping: a step longer than the target is thick passes through it between two end positions
+	float timeOfImpact = -1.0f;
+	glm::vec3 wallMin(-0.5f, -50.0f, -50.0f), wallMax(0.5f, 50.0f, 50.0f);
+	bool endOverlaps = boxesOverlap(glm::vec3(40.0f, 0.0f, 0.0f), glm::vec3(1.0f), wallMin, wallMax, 0.0f);
+	failed += !check(!endOverlaps && sweepBox(glm::vec3(-40.0f, 0.0f, 0.0f), glm::vec3(40.0f, 0.0f, 0.0f), glm::vec3(1.0f), wallMin, wallMax, timeOfImpact) &&
+		fabsf(timeOfImpact - 38.5f / 80.0f) < 1e-5f, "a thin wall is hit where the end position test tunnels through it");
+	failed += !check(sweepSphere(glm::vec3(-40.0f, 0.0f, 0.0f), glm::vec3(40.0f, 0.0f, 0.0f), 1.0f, glm::vec3(0.0f), 0.5f, timeOfImpact) &&
+		fabsf(timeOfImpact - 38.5f / 80.0f) < 1e-5f, "a small sphere is hit where the end position test tunnels through it");
+
+	//not moving at all: only an overlap at the start counts
+	failed += !check(sweepBox(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), wallMin, wallMax, timeOfImpact) && timeOfImpact == 0.0f &&
+		!sweepBox(glm::vec3(5.0f), glm::vec3(5.0f), glm::vec3(1.0f), wallMin, wallMax, timeOfImpact), "a box that does not move only hits what it starts in");
+	failed += !check(sweepSphere(glm::vec3(1.0f), glm::vec3(1.0f), 1.0f, glm::vec3(0.0f), 1.0f, timeOfImpact) && timeOfImpact == 0.0f &&
+		!sweepSphere(glm::vec3(5.0f), glm::vec3(5.0f), 1.0f, glm::vec3(0.0f), 1.0f, timeOfImpact), "a sphere that does not move only hits what it starts in");
+
+	//moving away from what it touches, and stopping short of it
+	failed += !check(!sweepSphere(glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(9.0f, 0.0f, 0.0f), 1.0f, glm::vec3(0.0f), 1.0f, timeOfImpact) &&
+		!sweepBox(glm::vec3(-40.0f, 0.0f, 0.0f), glm::vec3(-2.0f, 0.0f, 0.0f), glm::vec3(1.0f), wallMin, wallMax, timeOfImpact), "moving away or stopping short misses");
+
+	int sink = 0;
+	double boxNs = timeMs([&]() {
+		for (const SweepCase &test : cases)
+			sink += sweepBox(test.start, test.end, test.halfExtents, test.center - test.targetHalfExtents, test.center + test.targetHalfExtents, timeOfImpact);
+	}, 5) * 1e6 / cases.size();
+	double sphereNs = timeMs([&]() {
+		for (const SweepCase &test : cases)
+			sink += sweepSphere(test.start, test.end, test.radius, test.center, test.targetRadius, timeOfImpact);
+	}, 5) * 1e6 / cases.size();
+	double sampledNs = timeMs([&]() {
+		float first;
+		for (size_t i = 0; i < 1000; i++)
+			sink += sampleBox(cases[i].start, cases[i].end, cases[i].halfExtents, cases[i].center - cases[i].targetHalfExtents, cases[i].center + cases[i].targetHalfExtents, 0.0f, first);
+	}, 1) * 1e6 / 1000;
+	printf("  sweepBox %.1f ns, sweepSphere %.1f ns, box sampled at %d steps %.0f ns (%d hits over all timed runs)\n", boxNs, sphereNs, sampleCount, sampledNs, sink);
+	return failed;
+}
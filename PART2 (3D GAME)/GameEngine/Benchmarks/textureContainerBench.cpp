@@ -0,0 +1,262 @@
+#include "benchmark.h"
+#include "Model Loading\texture.h"
+#include "Model Loading\textureCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+
+static void put32(std::vector<unsigned char> &bytes, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		bytes[offset + i] = (unsigned char)(value >> (i * 8));
+}
+
+static void put64(std::vector<unsigned char> &bytes, size_t offset, uint64_t value)
+{
+	put32(bytes, offset, (uint32_t)value);
+	put32(bytes, offset + 4, (uint32_t)(value >> 32));
+}
+
+static size_t blockLevelSize(int width, int height, size_t blockBytes)
+{
+	return (size_t)std::max(1, (width + 3) / 4) * std::max(1, (height + 3) / 4) * blockBytes;
+}
+
+//a container as assetbake or a DCC tool writes it, with the faces and levels decodeContainer should find
+struct Container
+{
+	const char *name;
+	std::vector<unsigned char> bytes;
+	int faces;
+	int levels;
+	int width, height;
+};
+
+//legacy header with a DXT1 or DXT5 fourCC, or a DX10 header with a DXGI format; faces one after the other
+static Container makeDDS(const char *name, int width, int height, int levels, int faces, uint32_t fourCC, uint32_t dxgiFormat, size_t blockBytes)
+{
+	size_t headerSize = fourCC == 0x30315844 ? 148 : 128;
+	std::vector<unsigned char> bytes(headerSize, 0);
+	memcpy(bytes.data(), "DDS ", 4);
+	put32(bytes, 4, 124);
+	put32(bytes, 8, 0x1007 | 0x20000);
+	put32(bytes, 12, height);
+	put32(bytes, 16, width);
+	put32(bytes, 28, levels);
+	put32(bytes, 76, 32);
+	put32(bytes, 80, 0x4);
+	put32(bytes, 84, fourCC);
+	put32(bytes, 108, 0x1000 | 0x400000 | 0x8);
+	if (faces == 6)
+		put32(bytes, 112, 0x200 | 0xFC00);
+	if (headerSize == 148)
+	{
+		put32(bytes, 128, dxgiFormat);
+		put32(bytes, 132, 3);
+		put32(bytes, 136, faces == 6 ? 0x4 : 0);
+		put32(bytes, 140, 1);
+	}
+
+	for (int face = 0; face < faces; face++)
+		for (int level = 0; level < levels; level++)
+		{
+			size_t size = blockLevelSize(std::max(1, width >> level), std::max(1, height >> level), blockBytes);
+			for (size_t i = 0; i < size; i++)
+				bytes.push_back((unsigned char)(face * 31 + level * 7 + i));
+		}
+
+	Container container = { name, bytes, faces, levels, width, height };
+	return container;
+}
+
+//header, level index, then the levels smallest first like the spec recommends, each with its faces in a row
+static Container makeKTX2(const char *name, int width, int height, int levels, int faces, uint32_t vkFormat, size_t blockBytes, int channels)
+{
+	static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> bytes(80 + levels * 24, 0);
+	memcpy(bytes.data(), identifier, 12);
+	put32(bytes, 12, vkFormat);
+	put32(bytes, 16, 1);
+	put32(bytes, 20, width);
+	put32(bytes, 24, height);
+	put32(bytes, 36, faces);
+	put32(bytes, 40, levels);
+
+	for (int level = levels - 1; level >= 0; level--)
+	{
+		int levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+		size_t size = blockBytes ? blockLevelSize(levelWidth, levelHeight, blockBytes) : (size_t)levelWidth * levelHeight * channels;
+		put64(bytes, 80 + level * 24, bytes.size());
+		put64(bytes, 80 + level * 24 + 8, size * faces);
+		put64(bytes, 80 + level * 24 + 16, size * faces);
+		for (size_t i = 0; i < size * faces; i++)
+			bytes.push_back((unsigned char)(level * 13 + i));
+	}
+
+	Container container = { name, bytes, faces, levels, width, height };
+	return container;
+}
+
+static std::string containerPath(const Container &container)
+{
+	return temporaryPath(std::string("benchmark_container") + (container.bytes[0] == 'D' ? ".dds" : ".ktx2"));
+}
+
+static bool decodeBytes(const std::string &path, const std::vector<unsigned char> &bytes, std::vector<TextureData> &faces)
+{
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write((const char*)bytes.data(), bytes.size());
+	}
+	faces.clear();
+	return decodeContainer(path.c_str(), faces);
+}
+
+//what an accepted file must satisfy for the upload to be safe: every level inside the file, one to six faces
+//of the same size, a mip chain no longer than the image allows, each level half the one before
+static bool safelyDecoded(const std::vector<TextureData> &faces, size_t fileSize)
+{
+	if (faces.empty() || (faces.size() != 1 && faces.size() != 6))
+		return false;
+
+	for (const TextureData &face : faces)
+	{
+		if (face.width <= 0 || face.height <= 0 || face.levels.empty() || face.width != faces[0].width || face.height != faces[0].height)
+			return false;
+
+		int chain = 1;
+		for (int size = std::max(face.width, face.height); size > 1; size /= 2)
+			chain++;
+		if ((int)face.levels.size() > chain || face.levels.size() != faces[0].levels.size())
+			return false;
+
+		for (size_t i = 0; i < face.levels.size(); i++)
+		{
+			const TextureLevel &level = face.levels[i];
+			if (level.offset > fileSize || level.size > fileSize - level.offset || level.size == 0 ||
+				level.width != std::max(1, face.width >> i) || level.height != std::max(1, face.height >> i))
+				return false;
+		}
+	}
+	return true;
+}
+
+static int checkContainer(const Container &container, std::mt19937 &random, int &rejected, int &accepted)
+{
+	int failed = 0;
+	std::string path = containerPath(container);
+	std::string name = container.name;
+	std::vector<TextureData> faces;
+
+	bool decoded = decodeBytes(path, container.bytes, faces);
+	failed += !check(decoded && safelyDecoded(faces, container.bytes.size()) && (int)faces.size() == container.faces &&
+		(int)faces[0].levels.size() == container.levels && faces[0].width == container.width && faces[0].height == container.height,
+		(name + ": the valid file decodes with every face and level").c_str());
+
+	//every byte of these files is used, so a file cut anywhere is missing something
+	bool truncationsSafe = true;
+	for (size_t length = 0; length < container.bytes.size(); length++)
+	{
+		std::vector<unsigned char> truncated(container.bytes.begin(), container.bytes.begin() + length);
+		bool ok = decodeBytes(path, truncated, faces);
+		truncationsSafe = truncationsSafe && !ok;
+		ok ? accepted++ : rejected++;
+	}
+	failed += !check(truncationsSafe, (name + ": truncated files are refused").c_str());
+
+	//header fields overwritten with extreme values, and random bytes flipped anywhere in the headers
+	static const uint32_t extremes[] = { 0, 1, 6, 0x1F, 0x20, 0x40, 0xFFFF, 0x10000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+	size_t headerEnd = std::min<size_t>(container.bytes.size(), container.bytes[0] == 'D' ? 148 : 80 + container.levels * 24);
+	bool corruptionsSafe = true;
+	for (size_t offset = 4; offset + 4 <= headerEnd; offset += 4)
+		for (uint32_t value : extremes)
+		{
+			std::vector<unsigned char> corrupted = container.bytes;
+			put32(corrupted, offset, value);
+			bool ok = decodeBytes(path, corrupted, faces);
+			corruptionsSafe = corruptionsSafe && (!ok || safelyDecoded(faces, corrupted.size()));
+			ok ? accepted++ : rejected++;
+		}
+	std::uniform_int_distribution<size_t> position(0, headerEnd - 1);
+	std::uniform_int_distribution<int> byte(0, 255);
+	for (int i = 0; i < 500; i++)
+	{
+		std::vector<unsigned char> corrupted = container.bytes;
+		for (int flips = 0; flips < 4; flips++)
+			corrupted[position(random)] = (unsigned char)byte(random);
+		bool ok = decodeBytes(path, corrupted, faces);
+		corruptionsSafe = corruptionsSafe && (!ok || safelyDecoded(faces, corrupted.size()));
+		ok ? accepted++ : rejected++;
+	}
+	failed += !check(corruptionsSafe, (name + ": corrupted headers are refused or stay inside the file").c_str());
+
+	std::remove(path.c_str());
+	return failed;
+}
+
+int benchTextureContainers()
+{
+	int failed = 0;
+	std::mt19937 random(22);
+
+	std::vector<Container> containers;
+	containers.push_back(makeDDS("dds dxt1", 64, 32, 7, 1, 0x31545844, 0, 8));
+	containers.push_back(makeDDS("dds dx10 bc7 cubemap", 16, 16, 5, 6, 0x30315844, 98, 16));
+	containers.push_back(makeKTX2("ktx2 bc3", 32, 32, 6, 1, 137, 16, 4));
+	containers.push_back(makeKTX2("ktx2 rgba8 cubemap", 8, 8, 4, 6, 37, 0, 4));
+	containers.push_back(makeKTX2("ktx2 rgb8 odd size", 5, 3, 3, 1, 23, 0, 3));
+
+	int rejected = 0, accepted = 0;
+	for (const Container &container : containers)
+		failed += checkContainer(container, random, rejected, accepted);
+
+	//offsets in a KTX2 level index are 64 bit, offset + length must not wrap around to pass the size check
+	Container wrapped = containers[2];
+	put64(wrapped.bytes, 80, 0ull - 1024 + 16);
+	put64(wrapped.bytes, 88, 1024);
+	std::vector<TextureData> faces;
+	std::string path = containerPath(wrapped);
+	failed += !check(!decodeBytes(path, wrapped.bytes, faces), "a KTX2 level whose offset + length wraps around is refused");
+
+	//more levels than the image has, as long as the file is big enough to hold their index entries
+	Container deep = containers[2];
+	put32(deep.bytes, 40, 40);
+	deep.bytes.resize(80 + 40 * 24 + deep.bytes.size(), 0);
+	failed += !check(!decodeBytes(path, deep.bytes, faces), "a KTX2 file with more levels than its mip chain is refused");
+	std::remove(path.c_str());
+
+	Container deepDDS = containers[0];
+	put32(deepDDS.bytes, 28, 40);
+	deepDDS.bytes.resize(deepDDS.bytes.size() * 4, 0);
+	path = containerPath(deepDDS);
+	failed += !check(!decodeBytes(path, deepDDS.bytes, faces), "a DDS file with more levels than its mip chain is refused");
+	std::remove(path.c_str());
+
+	//the skybox: six 1500x1500 RGBA faces without mipmaps, and the planet skins as a mipmapped array with unloaded layers
+	std::vector<TextureData> skybox(6);
+	for (TextureData &face : skybox)
+	{
+		face.width = face.height = 1500;
+		face.channels = 4;
+	}
+	std::vector<TextureData> skins(3);
+	skins[0] = skybox[0];
+	failed += !check(cubemapSize(skybox) == 54000000, "a cubemap counts all six faces");
+	failed += !check(textureArraySize(skins) == 3 * textureSize(skybox[0]), "an array counts its empty layers as copies of the first");
+
+	//one texture per list of files and target, however the paths are spelled
+	std::vector<std::string> faceNames = { "Resources/Skybox/right.png", "Resources/Skybox/left.png" };
+	std::vector<std::string> respelled = { "Resources/../Resources/Skybox/right.png", "./Resources/Skybox/left.png" };
+	std::vector<std::string> swapped = { faceNames[1], faceNames[0] };
+	failed += !check(TextureCache::canonicalKey(faceNames, GL_TEXTURE_CUBE_MAP) == TextureCache::canonicalKey(respelled, GL_TEXTURE_CUBE_MAP) &&
+		TextureCache::canonicalKey(faceNames, GL_TEXTURE_CUBE_MAP) != TextureCache::canonicalKey(faceNames, GL_TEXTURE_2D_ARRAY) &&
+		TextureCache::canonicalKey(faceNames, GL_TEXTURE_CUBE_MAP) != TextureCache::canonicalKey(swapped, GL_TEXTURE_CUBE_MAP),
+		"cubemaps and arrays share a texture only for the same files in the same order");
+
+	printf("  %u valid containers, %d damaged ones refused, %d still accepted and checked to stay inside the file\n",
+		(unsigned int)containers.size(), rejected, accepted);
+	return failed;
+}
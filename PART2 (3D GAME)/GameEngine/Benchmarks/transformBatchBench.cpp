@@ -0,0 +1,151 @@
+#include "benchmark.h"
+#include "Game\transformBatch.h"
+#include "Jobs\cpuFeatures.h"
+#include <gtc\matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+static const char *simdNames[] = { "SSE2", "AVX", "AVX2" };
+
+//a model matrix inside something bigger, as the Transform component holds it
+struct PaddedMatrix
+{
+	float before[3];
+	glm::mat4 matrix;
+	float after[5];
+};
+
+//relative to the size of the matrix, so large translations do not need a looser bound than small ones
+static bool closeMatrices(const glm::mat4 &a, const glm::mat4 &b)
+{
+	float largest = 1.0f;
+	for (int c = 0; c < 4; c++)
+		for (int r = 0; r < 4; r++)
+			largest = std::max(largest, fabsf(b[c][r]));
+	for (int c = 0; c < 4; c++)
+		for (int r = 0; r < 4; r++)
+			if (fabsf(a[c][r] - b[c][r]) > largest * 1e-5f)
+				return false;
+	return true;
+}
+
+struct Instances
+{
+	std::vector<float> x, y, z, scaleX, scaleY, scaleZ;
+};
+
+static Instances randomInstances(unsigned int count, std::mt19937 &random)
+{
+	std::uniform_real_distribution<float> position(-5000.0f, 5000.0f), scale(0.5f, 15.0f);
+	Instances instances;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		instances.x.push_back(position(random));
+		instances.y.push_back(position(random));
+		instances.z.push_back(position(random));
+		instances.scaleX.push_back(scale(random));
+		instances.scaleY.push_back(scale(random));
+		instances.scaleZ.push_back(scale(random));
+	}
+	return instances;
+}
+
+//what the game did before the batch: a glm translate * rotation * scale chain per entity
+static glm::mat4 glmModel(const Instances &instances, const glm::mat3 &rotation, unsigned int i)
+{
+	return glm::translate(glm::mat4(1.0f), glm::vec3(instances.x[i], instances.y[i], instances.z[i])) * glm::mat4(rotation) *
+		glm::scale(glm::mat4(1.0f), glm::vec3(instances.scaleX[i], instances.scaleY[i], instances.scaleZ[i]));
+}
+
+int benchTransformBatch()
+{
+	int failed = 0;
+	SimdLevel detected = getSimdLevel();
+	printf("  processor supports %s\n", simdNames[detected]);
+
+	std::mt19937 random(16);
+	glm::mat3 rotation(glm::rotate(glm::mat4(1.0f), 0.7f, glm::normalize(glm::vec3(0.3f, 1.0f, -0.2f))));
+	glm::mat4 viewProjection = glm::perspective(45.0f, 16.0f / 9.0f, 0.1f, 10000.0f) *
+		glm::lookAt(glm::vec3(10.0f, 20.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	//the 8-wide kernel with no, one and several tails
+	const unsigned int counts[] = { 1, 7, 8, 9, 15, 17, 1023, 1024 };
+	std::vector<SimdLevel> levels = { SIMD_SSE2 };
+	if (detected >= SIMD_AVX2)
+		levels.push_back(SIMD_AVX2);
+
+	for (SimdLevel level : levels)
+	{
+		limitSimdLevel(level);
+		bool builtSame = true, paddingKept = true, multipliedSame = true, inPlaceSame = true;
+		for (unsigned int count : counts)
+		{
+			Instances instances = randomInstances(count, random);
+			std::vector<PaddedMatrix> padded(count);
+			for (PaddedMatrix &entry : padded)
+			{
+				std::fill(entry.before, entry.before + 3, -1.0f);
+				std::fill(entry.after, entry.after + 5, -2.0f);
+			}
+			buildModelMatrices(instances.x.data(), instances.y.data(), instances.z.data(), instances.scaleX.data(), instances.scaleY.data(),
+				instances.scaleZ.data(), rotation, count, &padded[0].matrix, sizeof(PaddedMatrix));
+
+			std::vector<glm::mat4> models(count), products(count);
+			for (unsigned int i = 0; i < count; i++)
+			{
+				builtSame = builtSame && closeMatrices(padded[i].matrix, glmModel(instances, rotation, i));
+				paddingKept = paddingKept && padded[i].before[2] == -1.0f && padded[i].after[0] == -2.0f;
+				models[i] = padded[i].matrix;
+			}
+
+			multiplyMatrices(viewProjection, models.data(), count, products.data());
+			for (unsigned int i = 0; i < count; i++)
+				multipliedSame = multipliedSame && closeMatrices(products[i], viewProjection * models[i]);
+
+			multiplyMatrices(viewProjection, models.data(), count, models.data());
+			inPlaceSame = inPlaceSame && models == products;
+		}
+
+		std::string path = simdNames[level];
+		failed += !check(builtSame, (path + ": buildModelMatrices matches translate * rotation * scale").c_str());
+		failed += !check(paddingKept, (path + ": buildModelMatrices leaves the bytes between strided matrices alone").c_str());
+		failed += !check(multipliedSame, (path + ": multiplyMatrices matches glm").c_str());
+		failed += !check(inPlaceSame, (path + ": multiplyMatrices can write over its input").c_str());
+	}
+
+	//timings over as many planets as a crowded frame could hold, one short of a multiple of 8
+	const unsigned int count = 100007;
+	Instances instances = randomInstances(count, random);
+	std::vector<glm::mat4> models(count), products(count);
+
+	double glmBuildMs = timeMs([&]() {
+		for (unsigned int i = 0; i < count; i++)
+			models[i] = glmModel(instances, rotation, i);
+	});
+	double glmMultiplyMs = timeMs([&]() {
+		for (unsigned int i = 0; i < count; i++)
+			products[i] = viewProjection * models[i];
+	});
+	printf("  %u matrices        build      multiply\n", count);
+	printf("  glm per entity  %8.3f ms  %8.3f ms\n", glmBuildMs, glmMultiplyMs);
+
+	for (SimdLevel level : levels)
+	{
+		limitSimdLevel(level);
+		double buildMs = timeMs([&]() {
+			buildModelMatrices(instances.x.data(), instances.y.data(), instances.z.data(), instances.scaleX.data(), instances.scaleY.data(),
+				instances.scaleZ.data(), rotation, count, models.data());
+		});
+		double multiplyMs = timeMs([&]() {
+			multiplyMatrices(viewProjection, models.data(), count, products.data());
+		});
+		printf("  batch %-8s  %8.3f ms  %8.3f ms  (%.2fx, %.2fx)\n", simdNames[level], buildMs, multiplyMs, glmBuildMs / buildMs, glmMultiplyMs / multiplyMs);
+	}
+	limitSimdLevel(SIMD_AVX2);
+
+	if (detected < SIMD_AVX2)
+		printf("  no AVX2 on this processor, only the scalar path was checked\n");
+	return failed;
+}
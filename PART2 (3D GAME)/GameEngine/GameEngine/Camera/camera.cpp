@@ -131,3 +131,28 @@ glm::vec3 Camera::getCameraRightDirection()
 {
     return glm::normalize(glm::cross(cameraViewDirection, cameraUp));
 }
+
+void Camera::updateFrustum(const glm::mat4 &projection)
+{
+    // Gribb/Hartmann: every plane is the last row of the matrix plus or minus one of the others
+    glm::mat4 viewProjection = projection * getViewMatrix();
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    frustumPlanes[0] = rows[3] + rows[0];
+    frustumPlanes[1] = rows[3] - rows[0];
+    frustumPlanes[2] = rows[3] + rows[1];
+    frustumPlanes[3] = rows[3] - rows[1];
+    frustumPlanes[4] = rows[3] + rows[2];
+    frustumPlanes[5] = rows[3] - rows[2];
+
+    // normalized so the plane distance of a point is in world units, as sphere tests need
+    for (int i = 0; i < 6; i++)
+        frustumPlanes[i] /= glm::length(glm::vec3(frustumPlanes[i]));
+}
+
+const glm::vec4* Camera::getFrustumPlanes()
+{
+    return frustumPlanes;
+}
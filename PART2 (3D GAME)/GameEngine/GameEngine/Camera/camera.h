@@ -18,6 +18,9 @@ class Camera
 		float rotationOx;
 		float rotationOy;
 
+		//left, right, bottom, top, near, far as (normal, distance), normals point inwards
+		glm::vec4 frustumPlanes[6];
+
 	public:
 		Camera();
 		Camera(glm::vec3 cameraPosition);
@@ -36,6 +39,10 @@ class Camera
 
 		glm::vec3 getCameraRightDirection();
 
+		//extracts the frustum planes of projection * view, call once per frame after moving the camera
+		void updateFrustum(const glm::mat4 &projection);
+		const glm::vec4* getFrustumPlanes();
+
 		void keyboardMoveFront(float cameraSpeed);
 		void keyboardMoveBack(float cameraSpeed);
 		void keyboardMoveLeft(float cameraSpeed);
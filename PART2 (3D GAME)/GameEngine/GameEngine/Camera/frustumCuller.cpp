@@ -0,0 +1,102 @@
+#include "frustumCuller.h"
+#include "frustumCullerAvx.h"
+#include "..\Jobs\cpuFeatures.h"
+#include <immintrin.h>
+
+void SphereBatch::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+}
+
+void SphereBatch::push(const glm::vec3 &center, float sphereRadius)
+{
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+    radius.push_back(sphereRadius);
+}
+
+unsigned int SphereBatch::size()
+{
+    return x.size();
+}
+
+// a sphere is culled when its center is further than its radius behind any plane
+static bool sphereVisible(const glm::vec4 planes[6], float x, float y, float z, float radius)
+{
+    for (int p = 0; p < 6; p++)
+    {
+        float distance = planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w;
+        if (distance < -radius)
+            return false;
+    }
+    return true;
+}
+
+void cullSpheres(const glm::vec4 planes[6], SphereBatch &spheres, float radiusScale, std::vector<unsigned int> &visible, CullStats &stats)
+{
+    cullSpheres(planes, spheres, 0, spheres.size(), radiusScale, visible, stats);
+}
+
+void cullSpheres(const glm::vec4 planes[6], SphereBatch &spheres, unsigned int first, unsigned int last, float radiusScale, std::vector<unsigned int> &visible, CullStats &stats)
+{
+    const float *xs = spheres.x.data();
+    const float *ys = spheres.y.data();
+    const float *zs = spheres.z.data();
+    const float *radii = spheres.radius.data();
+    size_t visibleBefore = visible.size();
+    unsigned int i = first;
+
+    if (getSimdLevel() >= SIMD_AVX && last - first >= 8)
+    {
+        // room for every sphere of the 8-wide part, trimmed back to the ones that were visible
+        unsigned int blocks = (last - first) / 8;
+        size_t start = visible.size();
+        visible.resize(start + blocks * 8);
+        unsigned int written = cullSpheresAvx(&planes[0].x, xs, ys, zs, radii, first, blocks, radiusScale, visible.data() + start);
+        visible.resize(start + written);
+        i += blocks * 8;
+    }
+
+    __m128 planeX4[6], planeY4[6], planeZ4[6], planeW4[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX4[p] = _mm_set1_ps(planes[p].x);
+        planeY4[p] = _mm_set1_ps(planes[p].y);
+        planeZ4[p] = _mm_set1_ps(planes[p].z);
+        planeW4[p] = _mm_set1_ps(planes[p].w);
+    }
+    __m128 negativeScale4 = _mm_set1_ps(-radiusScale);
+
+    for (; i + 4 <= last; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        __m128 z = _mm_loadu_ps(zs + i);
+        __m128 negativeRadius = _mm_mul_ps(negativeScale4, _mm_loadu_ps(radii + i));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX4[p], x), _mm_mul_ps(planeY4[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ4[p], z), planeW4[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (unsigned int lane = 0; lane < 4; lane++)
+            if (mask & (1 << lane))
+                visible.push_back(i + lane);
+    }
+
+    // the last few spheres that do not fill a register
+    for (; i < last; i++)
+        if (sphereVisible(planes, xs[i], ys[i], zs[i], radii[i] * radiusScale))
+            visible.push_back(i);
+
+    stats.tested = last - first;
+    stats.visible = visible.size() - visibleBefore;
+}
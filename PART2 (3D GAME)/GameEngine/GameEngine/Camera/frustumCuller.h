@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <glm.hpp>
+
+//bounding spheres kept as separate arrays so a SIMD register holds the same coordinate of several spheres
+struct SphereBatch
+{
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radius;
+
+	void clear();
+	void push(const glm::vec3 &center, float sphereRadius);
+	unsigned int size();
+};
+
+//spheres tested and found at least partly inside the frustum by the last cullSpheres call
+struct CullStats
+{
+	unsigned int tested;
+	unsigned int visible;
+};
+
+//appends to visible the index of every sphere not completely behind one of the 6 planes
+//8 spheres at a time when the processor has AVX, 4 with SSE otherwise; every radius is multiplied by radiusScale
+void cullSpheres(const glm::vec4 planes[6], SphereBatch &spheres, float radiusScale, std::vector<unsigned int> &visible, CullStats &stats);
+//the same for the spheres first to last - 1 only, so separate ranges can be culled on separate threads
+void cullSpheres(const glm::vec4 planes[6], SphereBatch &spheres, unsigned int first, unsigned int last, float radiusScale, std::vector<unsigned int> &visible, CullStats &stats);
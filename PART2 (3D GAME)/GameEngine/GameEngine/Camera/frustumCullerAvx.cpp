@@ -0,0 +1,44 @@
+#include "frustumCullerAvx.h"
+#include <immintrin.h>
+
+unsigned int cullSpheresAvx(const float planes[24], const float *xs, const float *ys, const float *zs, const float *radii,
+                            unsigned int first, unsigned int count, float radiusScale, unsigned int *visible)
+{
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm256_set1_ps(planes[p * 4 + 0]);
+        planeY[p] = _mm256_set1_ps(planes[p * 4 + 1]);
+        planeZ[p] = _mm256_set1_ps(planes[p * 4 + 2]);
+        planeW[p] = _mm256_set1_ps(planes[p * 4 + 3]);
+    }
+    __m256 negativeScale = _mm256_set1_ps(-radiusScale);
+
+    unsigned int written = 0;
+    unsigned int last = first + count * 8;
+    for (unsigned int i = first; i < last; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 z = _mm256_loadu_ps(zs + i);
+        __m256 negativeRadius = _mm256_mul_ps(negativeScale, _mm256_loadu_ps(radii + i));
+
+        // lanes stay set while every plane so far has the sphere in front of or across it
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (unsigned int lane = 0; lane < 8; lane++)
+            if (mask & (1 << lane))
+                visible[written++] = i + lane;
+    }
+
+    // upper halves of the ymm registers are cleared so the SSE code after this does not pay for the switch
+    _mm256_zeroupper();
+    return written;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// the 8-wide loop of cullSpheres; frustumCullerAvx.cpp is the only file built with /arch:AVX, so it
+// takes plain arrays and keeps glm and std templates out, and is only called when getSimdLevel allows
+// planes holds x, y, z, w of the 6 planes; tests the spheres first to first + count * 8 - 1, writes the
+// index of each visible one to visible and returns how many it wrote
+unsigned int cullSpheresAvx(const float planes[24], const float *xs, const float *ys, const float *zs, const float *radii,
+                            unsigned int first, unsigned int count, float radiusScale, unsigned int *visible);
@@ -0,0 +1,43 @@
+#pragma once
+#include <glm.hpp>
+
+//where an entity is; model is rebuilt from the other fields by transformSystem
+struct Transform
+{
+	glm::vec3 position;
+	glm::vec3 previousPosition;   //position before the last simulation step, drawn frames lie in between
+	glm::vec3 scale;
+	glm::vec3 rotationAxis;
+	float rotationAngle;    //radians
+	glm::mat4 model;
+};
+
+//spins the entity around its transform's rotation axis
+struct Rotator
+{
+	float speed;            //relative to the phase given to rotatorSystem
+};
+
+//world space box around the entity, rebuilt from the collider by boundsSystem
+struct Bounds
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+//cube the entity collides with, centered on its position
+struct Collider
+{
+	float halfExtent;
+};
+
+#define RENDER_INSTANCED 1  //drawn with every other instance of its model in one call per level of detail
+#define RENDER_THRUSTER 2   //drawn with the thruster flame instead of its texture
+
+//what to draw the entity with; model indexes the table of meshes and materials owned by the game
+struct Renderable
+{
+	unsigned int model;
+	unsigned int flags;
+	unsigned int layer;     //layer of the model's texture array, for instanced models
+};
@@ -0,0 +1,154 @@
+#include "sectorStreamer.h"
+#include <algorithm>
+
+//splitmix64 finalizer, every input bit affects every output bit
+static uint64_t mix64(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+SectorRandom::SectorRandom(uint64_t key)
+{
+	this->key = key;
+	counter = 0;
+}
+
+uint32_t SectorRandom::next()
+{
+	counter++;
+	return (uint32_t)(mix64(key + counter * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+float SectorRandom::nextFloat()
+{
+	//24 bits, as many as a float holds below 1
+	return (next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float SectorRandom::range(float min, float max)
+{
+	return min + (max - min) * nextFloat();
+}
+
+SectorStreamer::SectorStreamer(float sectorSize, unsigned int capacity)
+{
+	this->sectorSize = sectorSize;
+	ahead = behind = side = sectorSize;
+	seed = 0;
+
+	sectors.resize(capacity);
+	for (unsigned int i = capacity; i > 0; i--)
+		freeSectors.push_back(i - 1);
+	loaded.reserve(capacity);
+}
+
+void SectorStreamer::setSeed(uint64_t seed)
+{
+	this->seed = seed;
+}
+
+uint64_t SectorStreamer::getSeed()
+{
+	return seed;
+}
+
+void SectorStreamer::setRange(float ahead, float behind, float side)
+{
+	this->ahead = ahead;
+	this->behind = behind;
+	this->side = side;
+}
+
+uint64_t SectorStreamer::sectorKey(const glm::ivec3 &coordinate)
+{
+	return ((uint64_t)(coordinate.x & 0x1FFFFF) << 42) | ((uint64_t)(coordinate.y & 0x1FFFFF) << 21) | (uint64_t)(coordinate.z & 0x1FFFFF);
+}
+
+bool SectorStreamer::inRange(const glm::ivec3 &coordinate, const glm::vec3 &position, const glm::vec3 &forward, float &distance)
+{
+	glm::vec3 offset = (glm::vec3(coordinate) + 0.5f) * sectorSize - position;
+	float along = glm::dot(offset, forward);
+	float beside = glm::length(offset - forward * along);
+	distance = glm::length(offset);
+
+	return along >= -behind && along <= ahead && beside <= side;
+}
+
+void SectorStreamer::update(const glm::vec3 &position, const glm::vec3 &forward, const LoadFunction &load, const UnloadFunction &unload)
+{
+	glm::vec3 direction = glm::normalize(forward);
+	float distance;
+
+	for (auto it = loaded.begin(); it != loaded.end();)
+	{
+		if (inRange(sectors[it->second].coordinate, position, direction, distance))
+		{
+			++it;
+			continue;
+		}
+
+		unload(sectors[it->second]);
+		freeSectors.push_back(it->second);
+		it = loaded.erase(it);
+	}
+
+	//every sector center that can be in range lies within reach sectors of the camera's
+	glm::ivec3 center = glm::ivec3(glm::floor(position / sectorSize));
+	int reach = (int)glm::ceil(std::max(ahead, std::max(behind, side)) / sectorSize) + 1;
+	candidates.clear();
+	for (int x = -reach; x <= reach; x++)
+		for (int y = -reach; y <= reach; y++)
+			for (int z = -reach; z <= reach; z++)
+			{
+				glm::ivec3 coordinate = center + glm::ivec3(x, y, z);
+				if (loaded.count(sectorKey(coordinate)) == 0 && inRange(coordinate, position, direction, distance))
+				{
+					Candidate candidate = { distance, coordinate };
+					candidates.push_back(candidate);
+				}
+			}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) { return a.distance < b.distance; });
+
+	for (size_t i = 0; i < candidates.size() && !freeSectors.empty(); i++)
+	{
+		unsigned int slot = freeSectors.back();
+		freeSectors.pop_back();
+
+		Sector &sector = sectors[slot];
+		sector.coordinate = candidates[i].coordinate;
+		sector.boundsMin = glm::vec3(sector.coordinate) * sectorSize;
+		sector.boundsMax = sector.boundsMin + glm::vec3(sectorSize);
+		sector.entityCount = 0;
+
+		uint64_t key = sectorKey(sector.coordinate);
+		SectorRandom random(mix64(seed ^ mix64(key)));
+		load(sector, random);
+		loaded[key] = slot;
+	}
+}
+
+void SectorStreamer::clear(const UnloadFunction &unload)
+{
+	for (auto it = loaded.begin(); it != loaded.end(); ++it)
+	{
+		unload(sectors[it->second]);
+		freeSectors.push_back(it->second);
+	}
+	loaded.clear();
+}
+
+unsigned int SectorStreamer::getLoadedCount()
+{
+	return loaded.size();
+}
+
+unsigned int SectorStreamer::getCapacity()
+{
+	return sectors.size();
+}
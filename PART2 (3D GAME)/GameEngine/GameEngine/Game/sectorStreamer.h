@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <glm.hpp>
+#include "world.h"
+
+#define MAX_SECTOR_ENTITIES 32
+
+//counter based generator: the n-th number depends only on the key and n, so a sector
+//generates the same contents whenever and in whatever order it is loaded
+class SectorRandom
+{
+	public:
+		SectorRandom(uint64_t key);
+
+		uint32_t next();
+		//uniform in [0, 1)
+		float nextFloat();
+		float range(float min, float max);
+
+	private:
+		uint64_t key;
+		uint64_t counter;
+};
+
+//a cube of the world, loaded as a whole; entities holds what its load function created
+struct Sector
+{
+	glm::ivec3 coordinate;
+	glm::vec3 boundsMin, boundsMax;
+	unsigned int entityCount;
+	Entity entities[MAX_SECTOR_ENTITIES];
+};
+
+//keeps the sectors around the camera loaded: ahead along the flight direction, a little behind and to the sides;
+//sectors live in a fixed pool, so at most capacity sectors are ever loaded
+class SectorStreamer
+{
+	public:
+		typedef std::function<void(Sector&, SectorRandom&)> LoadFunction;
+		typedef std::function<void(Sector&)> UnloadFunction;
+
+		SectorStreamer(float sectorSize, unsigned int capacity);
+
+		//the same seed always generates the same sectors
+		void setSeed(uint64_t seed);
+		uint64_t getSeed();
+		//how far sector centers may be ahead of, behind and beside the camera
+		void setRange(float ahead, float behind, float side);
+
+		//unloads the sectors out of range, then loads the missing ones nearest first while the pool has room
+		void update(const glm::vec3 &position, const glm::vec3 &forward, const LoadFunction &load, const UnloadFunction &unload);
+		void clear(const UnloadFunction &unload);
+
+		unsigned int getLoadedCount();
+		unsigned int getCapacity();
+
+	private:
+		struct Candidate
+		{
+			float distance;
+			glm::ivec3 coordinate;
+		};
+
+		float sectorSize;
+		float ahead, behind, side;
+		uint64_t seed;
+		std::vector<Sector> sectors;
+		std::vector<unsigned int> freeSectors;
+		std::unordered_map<uint64_t, unsigned int> loaded;
+		std::vector<Candidate> candidates;
+
+		bool inRange(const glm::ivec3 &coordinate, const glm::vec3 &position, const glm::vec3 &forward, float &distance);
+		static uint64_t sectorKey(const glm::ivec3 &coordinate);
+};
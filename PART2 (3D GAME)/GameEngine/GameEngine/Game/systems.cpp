@@ -0,0 +1,92 @@
+#include "systems.h"
+#include "transformBatch.h"
+#include <gtc\matrix_transform.hpp>
+
+//f(count, entities, arrays...) with a job per chunk; every chunk has its own arrays, so the jobs need no locking
+template<class... C, class F> static void parallelEachChunk(World &world, JobSystem &jobs, F f)
+{
+	JobCounter counter;
+	world.eachChunk<C...>([&](unsigned int count, Entity *entities, C*... arrays) {
+		jobs.run([=]() { f(count, entities, arrays...); }, &counter);
+	});
+	jobs.wait(counter);
+}
+
+//f(entity, components...) the same way
+template<class... C, class F> static void parallelEach(World &world, JobSystem &jobs, F f)
+{
+	parallelEachChunk<C...>(world, jobs, [f](unsigned int count, Entity *entities, C*... arrays) {
+		for (unsigned int i = 0; i < count; i++)
+			f(entities[i], arrays[i]...);
+	});
+}
+
+void rotatorSystem(World &world, JobSystem &jobs, float phase)
+{
+	parallelEach<Transform, Rotator>(world, jobs, [phase](Entity, Transform &transform, Rotator &rotator) {
+		transform.rotationAngle = rotator.speed * phase;
+	});
+}
+
+void snapshotSystem(World &world, JobSystem &jobs)
+{
+	parallelEach<Transform>(world, jobs, [](Entity, Transform &transform) {
+		transform.previousPosition = transform.position;
+	});
+}
+
+static glm::mat4 buildModelMatrix(const Transform &transform, float blend)
+{
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::mix(transform.previousPosition, transform.position, blend));
+	//this glm takes degrees
+	if (transform.rotationAngle != 0.0f)
+		model = glm::rotate(model, glm::degrees(transform.rotationAngle), transform.rotationAxis);
+	return glm::scale(model, transform.scale);
+}
+
+void transformSystem(World &world, JobSystem &jobs, float blend)
+{
+	parallelEachChunk<Transform>(world, jobs, [blend](unsigned int count, Entity*, Transform *transforms) {
+		//every planet spins around the same axis by the same angle, so a chunk usually shares one rotation
+		const Transform &first = transforms[0];
+		for (unsigned int i = 1; i < count; i++)
+		{
+			if (transforms[i].rotationAngle != first.rotationAngle || transforms[i].rotationAxis != first.rotationAxis)
+			{
+				for (unsigned int j = 0; j < count; j++)
+					transforms[j].model = buildModelMatrix(transforms[j], blend);
+				return;
+			}
+		}
+
+		glm::mat3 rotation(1.0f);
+		if (first.rotationAngle != 0.0f)
+			rotation = glm::mat3(glm::rotate(glm::mat4(1.0f), glm::degrees(first.rotationAngle), first.rotationAxis));
+
+		//the batch reads positions and scales as separate arrays
+		static thread_local std::vector<float> separate;
+		separate.resize(count * 6);
+		float *x = separate.data(), *y = x + count, *z = y + count;
+		float *scaleX = z + count, *scaleY = scaleX + count, *scaleZ = scaleY + count;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::vec3 position = glm::mix(transforms[i].previousPosition, transforms[i].position, blend);
+			x[i] = position.x;
+			y[i] = position.y;
+			z[i] = position.z;
+			scaleX[i] = transforms[i].scale.x;
+			scaleY[i] = transforms[i].scale.y;
+			scaleZ[i] = transforms[i].scale.z;
+		}
+
+		buildModelMatrices(x, y, z, scaleX, scaleY, scaleZ, rotation, count, &transforms[0].model, sizeof(Transform));
+	});
+}
+
+void boundsSystem(World &world, JobSystem &jobs)
+{
+	parallelEach<Transform, Collider, Bounds>(world, jobs, [](Entity, Transform &transform, Collider &collider, Bounds &bounds) {
+		bounds.min = transform.position - glm::vec3(collider.halfExtent);
+		bounds.max = transform.position + glm::vec3(collider.halfExtent);
+	});
+}
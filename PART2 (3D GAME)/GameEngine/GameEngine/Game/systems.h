@@ -0,0 +1,15 @@
+#pragma once
+#include "world.h"
+#include "components.h"
+#include "..\Jobs\jobSystem.h"
+
+//every system runs one job per chunk and returns once all of them have finished
+
+//rotation angle = speed * phase, phase being the global rotation speed times the time
+void rotatorSystem(World &world, JobSystem &jobs, float phase);
+//keeps the positions before a simulation step moves anything
+void snapshotSystem(World &world, JobSystem &jobs);
+//model matrices from rotation, scale and the position blend fraction of the way from the previous to the current one
+void transformSystem(World &world, JobSystem &jobs, float blend);
+//world space boxes from position and collider
+void boundsSystem(World &world, JobSystem &jobs);
@@ -0,0 +1,39 @@
+#include "transformBatch.h"
+#include "transformBatchAvx2.h"
+#include "..\Jobs\cpuFeatures.h"
+
+//the columns of T * R * S are the rotation columns times the scale, and the position
+void buildModelMatrices(const float *x, const float *y, const float *z,
+	const float *scaleX, const float *scaleY, const float *scaleZ,
+	const glm::mat3 &rotation, unsigned int count, glm::mat4 *out, size_t stride)
+{
+	unsigned char *bytes = (unsigned char*)out;
+	unsigned int i = 0;
+
+	if (getSimdLevel() >= SIMD_AVX2)
+		i = buildModelMatricesAvx2(x, y, z, scaleX, scaleY, scaleZ, &rotation[0][0], count, (float*)out, stride);
+
+	for (; i < count; i++)
+	{
+		glm::mat4 &model = *(glm::mat4*)(bytes + i * stride);
+		model[0] = glm::vec4(rotation[0] * scaleX[i], 0.0f);
+		model[1] = glm::vec4(rotation[1] * scaleY[i], 0.0f);
+		model[2] = glm::vec4(rotation[2] * scaleZ[i], 0.0f);
+		model[3] = glm::vec4(x[i], y[i], z[i], 1.0f);
+	}
+}
+
+void multiplyMatrices(const glm::mat4 &left, const glm::mat4 *right, unsigned int count, glm::mat4 *out)
+{
+	if (getSimdLevel() >= SIMD_AVX2)
+	{
+		multiplyMatricesAvx2(&left[0][0], (const float*)right, count, (float*)out);
+		return;
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		glm::mat4 product = left * right[i];
+		out[i] = product;
+	}
+}
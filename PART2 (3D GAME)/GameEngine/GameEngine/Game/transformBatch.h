@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <glm.hpp>
+
+//out[i] = translate(position i) * rotation * scale(scale i) for count entities sharing one rotation,
+//positions and scales given as separate x/y/z arrays; 8 matrices at a time when the processor has AVX2, one at a time otherwise
+//stride is the distance in bytes from one output matrix to the next, so they can be written inside larger structs
+void buildModelMatrices(const float *x, const float *y, const float *z,
+	const float *scaleX, const float *scaleY, const float *scaleZ,
+	const glm::mat3 &rotation, unsigned int count, glm::mat4 *out, size_t stride = sizeof(glm::mat4));
+
+//out[i] = left * right[i], for model-view-projection matrices built on the cpu; out may be right
+//with AVX2 the products use fused multiply-add and can differ from glm's in the last bits
+void multiplyMatrices(const glm::mat4 &left, const glm::mat4 *right, unsigned int count, glm::mat4 *out);
@@ -0,0 +1,104 @@
+#include "transformBatchAvx2.h"
+#include <immintrin.h>
+
+//rows[e] holds element e of 8 matrices, afterwards rows[m] holds the 8 elements of matrix m
+static void transpose8(__m256 rows[8])
+{
+	__m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+	__m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+	__m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+	__m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+	__m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+	__m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+	__m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+	__m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+unsigned int buildModelMatricesAvx2(const float *x, const float *y, const float *z,
+	const float *scaleX, const float *scaleY, const float *scaleZ,
+	const float rotation[9], unsigned int count, float *out, size_t stride)
+{
+	__m256 r[3][3];
+	for (int column = 0; column < 3; column++)
+		for (int row = 0; row < 3; row++)
+			r[column][row] = _mm256_set1_ps(rotation[column * 3 + row]);
+	__m256 zero = _mm256_setzero_ps();
+	__m256 one = _mm256_set1_ps(1.0f);
+
+	unsigned int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 scale[3] = { _mm256_loadu_ps(scaleX + i), _mm256_loadu_ps(scaleY + i), _mm256_loadu_ps(scaleZ + i) };
+
+		//element e of the 8 matrices, in glm's column major order
+		__m256 elements[16];
+		for (int column = 0; column < 3; column++)
+		{
+			for (int row = 0; row < 3; row++)
+				elements[column * 4 + row] = _mm256_mul_ps(r[column][row], scale[column]);
+			elements[column * 4 + 3] = zero;
+		}
+		elements[12] = _mm256_loadu_ps(x + i);
+		elements[13] = _mm256_loadu_ps(y + i);
+		elements[14] = _mm256_loadu_ps(z + i);
+		elements[15] = one;
+
+		//first and second half of every matrix
+		transpose8(elements);
+		transpose8(elements + 8);
+		for (int m = 0; m < 8; m++)
+		{
+			float *matrix = (float*)((unsigned char*)out + (i + m) * stride);
+			_mm256_storeu_ps(matrix, elements[m]);
+			_mm256_storeu_ps(matrix + 8, elements[8 + m]);
+		}
+	}
+
+	_mm256_zeroupper();
+	return i;
+}
+
+void multiplyMatricesAvx2(const float left[16], const float *right, unsigned int count, float *out)
+{
+	//every column of left twice, so one register works on two columns of the result
+	const float *l = left;
+	__m256 l0 = _mm256_broadcast_ps((const __m128*)(l + 0));
+	__m256 l1 = _mm256_broadcast_ps((const __m128*)(l + 4));
+	__m256 l2 = _mm256_broadcast_ps((const __m128*)(l + 8));
+	__m256 l3 = _mm256_broadcast_ps((const __m128*)(l + 12));
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const float *r = right + i * 16;
+		float *o = out + i * 16;
+		for (int half = 0; half < 16; half += 8)
+		{
+			__m256 columns = _mm256_loadu_ps(r + half);
+			__m256 result = _mm256_mul_ps(l0, _mm256_permute_ps(columns, 0x00));
+			result = _mm256_fmadd_ps(l1, _mm256_permute_ps(columns, 0x55), result);
+			result = _mm256_fmadd_ps(l2, _mm256_permute_ps(columns, 0xAA), result);
+			result = _mm256_fmadd_ps(l3, _mm256_permute_ps(columns, 0xFF), result);
+			_mm256_storeu_ps(o + half, result);
+		}
+	}
+
+	_mm256_zeroupper();
+}
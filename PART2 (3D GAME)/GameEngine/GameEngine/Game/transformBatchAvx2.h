@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+//the AVX2 and FMA kernels of transformBatch.cpp; only transformBatchAvx2.cpp is built with /arch:AVX2, so these
+//take plain column major floats and keep glm out of it, and are only called when getSimdLevel allows
+
+//the first count / 8 * 8 matrices of buildModelMatrices, returns how many it wrote
+unsigned int buildModelMatricesAvx2(const float *x, const float *y, const float *z,
+	const float *scaleX, const float *scaleY, const float *scaleZ,
+	const float rotation[9], unsigned int count, float *out, size_t stride);
+
+//all count products of multiplyMatrices; fused multiply-add, so results can differ from glm in the last bits
+void multiplyMatricesAvx2(const float left[16], const float *right, unsigned int count, float *out);
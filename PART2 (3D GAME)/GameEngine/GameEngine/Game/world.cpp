@@ -0,0 +1,182 @@
+#include "world.h"
+#include <cstring>
+
+static std::vector<size_t>& componentSizes()
+{
+	static std::vector<size_t> sizes;
+	return sizes;
+}
+
+unsigned int registerComponent(size_t size)
+{
+	componentSizes().push_back(size);
+	return componentSizes().size() - 1;
+}
+
+World::World()
+{
+	alive = 0;
+}
+
+World::~World()
+{
+	for (size_t i = 0; i < archetypes.size(); i++)
+		delete archetypes[i];
+}
+
+Archetype& World::getArchetype(ComponentMask mask)
+{
+	for (size_t i = 0; i < archetypes.size(); i++)
+		if (archetypes[i]->mask == mask)
+			return *archetypes[i];
+
+	Archetype *archetype = new Archetype();
+	archetype->mask = mask;
+	archetype->count = 0;
+
+	//as many entities as fit in CHUNK_BYTES, never less than one
+	size_t entityBytes = 0;
+	for (unsigned int id = 0; id < MAX_COMPONENTS; id++)
+		if (mask & (1u << id))
+			entityBytes += componentSizes()[id];
+	archetype->chunkCapacity = entityBytes > 0 ? (unsigned int)(CHUNK_BYTES / entityBytes) : CHUNK_BYTES;
+	if (archetype->chunkCapacity == 0)
+		archetype->chunkCapacity = 1;
+
+	//one array per component, each starting on a 16 byte boundary
+	size_t offset = 0;
+	for (unsigned int id = 0; id < MAX_COMPONENTS; id++)
+	{
+		archetype->offsets[id] = offset;
+		if (mask & (1u << id))
+			offset += (componentSizes()[id] * archetype->chunkCapacity + 15) & ~(size_t)15;
+	}
+
+	archetypes.push_back(archetype);
+	return *archetype;
+}
+
+void World::addChunk(Archetype &archetype)
+{
+	size_t bytes = 0;
+	for (unsigned int id = 0; id < MAX_COMPONENTS; id++)
+		if (archetype.mask & (1u << id))
+			bytes = archetype.offsets[id] + componentSizes()[id] * archetype.chunkCapacity;
+
+	Chunk chunk;
+	chunk.count = 0;
+	chunk.entities.resize(archetype.chunkCapacity);
+	chunk.data.resize(bytes);
+	archetype.chunks.push_back(chunk);
+}
+
+Entity World::allocate(Archetype &archetype)
+{
+	unsigned int index;
+	if (!freeRecords.empty())
+	{
+		index = freeRecords.back();
+		freeRecords.pop_back();
+	}
+	else
+	{
+		index = records.size();
+		Record record = { 0, nullptr, 0, 0 };
+		records.push_back(record);
+	}
+
+	unsigned int chunkIndex = archetype.count / archetype.chunkCapacity;
+	if (chunkIndex == archetype.chunks.size())
+		addChunk(archetype);
+
+	Chunk &chunk = archetype.chunks[chunkIndex];
+	Entity entity = { index, records[index].generation };
+	chunk.entities[chunk.count] = entity;
+
+	Record &record = records[index];
+	record.archetype = &archetype;
+	record.chunk = chunkIndex;
+	record.row = chunk.count;
+
+	chunk.count++;
+	archetype.count++;
+	alive++;
+
+	return entity;
+}
+
+void World::destroy(Entity entity)
+{
+	if (!isAlive(entity))
+		return;
+
+	Record &record = records[entity.index];
+	Archetype &archetype = *record.archetype;
+	Chunk &chunk = archetype.chunks[record.chunk];
+
+	unsigned int last = archetype.count - 1;
+	Chunk &lastChunk = archetype.chunks[last / archetype.chunkCapacity];
+	unsigned int lastRow = last % archetype.chunkCapacity;
+
+	if (&lastChunk != &chunk || lastRow != record.row)
+	{
+		for (unsigned int id = 0; id < MAX_COMPONENTS; id++)
+		{
+			if (archetype.mask & (1u << id))
+			{
+				size_t size = componentSizes()[id];
+				memcpy(chunk.data.data() + archetype.offsets[id] + size * record.row,
+					lastChunk.data.data() + archetype.offsets[id] + size * lastRow, size);
+			}
+		}
+
+		Entity moved = lastChunk.entities[lastRow];
+		chunk.entities[record.row] = moved;
+		records[moved.index].chunk = record.chunk;
+		records[moved.index].row = record.row;
+	}
+
+	//the chunk stays allocated for the next entities of this archetype
+	lastChunk.count--;
+	archetype.count--;
+	alive--;
+
+	record.generation++;
+	record.archetype = nullptr;
+	freeRecords.push_back(entity.index);
+}
+
+bool World::isAlive(Entity entity)
+{
+	return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+		records[entity.index].archetype != nullptr;
+}
+
+Entity World::getEntity(unsigned int index)
+{
+	Entity entity = { index, 0 };
+	if (index < records.size())
+		entity.generation = records[index].archetype != nullptr ? records[index].generation : records[index].generation + 1;
+	return entity;
+}
+
+unsigned int World::size()
+{
+	return alive;
+}
+
+SystemTiming& World::timing(const char *name)
+{
+	for (size_t i = 0; i < timings.size(); i++)
+		if (timings[i].name == name)
+			return timings[i];
+
+	SystemTiming added = { name, 0.0 };
+	timings.push_back(added);
+	return timings.back();
+}
+
+const std::vector<SystemTiming>& World::getSystemTimings()
+{
+	return timings;
+}
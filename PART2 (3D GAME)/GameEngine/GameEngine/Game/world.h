@@ -0,0 +1,173 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+//refers to an entity for as long as it lives; once it is destroyed the generation no longer matches
+struct Entity
+{
+	unsigned int index;
+	unsigned int generation;
+};
+
+#define MAX_COMPONENTS 32
+#define CHUNK_BYTES 16384
+
+typedef uint32_t ComponentMask;
+
+//component types are numbered in the order they are first used
+unsigned int registerComponent(size_t size);
+
+template<class T> unsigned int componentId()
+{
+	//components are moved around with memcpy and never destroyed; glm types declare copy
+	//constructors so they are not trivially copyable, but memcpy moves them just as well
+	static_assert(std::is_trivially_destructible<T>::value, "components have to be plain data");
+	static unsigned int id = registerComponent(sizeof(T));
+	return id;
+}
+
+template<class... C> ComponentMask componentMask()
+{
+	return (0u | ... | (1u << componentId<C>()));
+}
+
+//a fixed block of up to capacity entities of one archetype, every component in its own contiguous array
+struct Chunk
+{
+	unsigned int count;
+	std::vector<Entity> entities;
+	std::vector<unsigned char> data;
+};
+
+//all entities with exactly the same set of components; chunks are kept full except the last used one
+struct Archetype
+{
+	ComponentMask mask;
+	unsigned int chunkCapacity;
+	unsigned int count;
+	size_t offsets[MAX_COMPONENTS];
+	std::vector<Chunk> chunks;
+
+	template<class T> T* array(Chunk &chunk)
+	{
+		return (T*)(chunk.data.data() + offsets[componentId<T>()]);
+	}
+};
+
+//time the last run of a system took
+struct SystemTiming
+{
+	std::string name;
+	double milliseconds;
+};
+
+class World
+{
+	public:
+		World();
+		~World();
+
+		template<class... C> Entity create(const C&... components)
+		{
+			Archetype &archetype = getArchetype(componentMask<C...>());
+			Entity entity = allocate(archetype);
+
+			Record &record = records[entity.index];
+			Chunk &chunk = archetype.chunks[record.chunk];
+			((archetype.array<C>(chunk)[record.row] = components), ...);
+
+			return entity;
+		}
+
+		//the last entity of the archetype moves into the hole, handles to it stay valid
+		void destroy(Entity entity);
+		bool isAlive(Entity entity);
+		//handle of the entity living at index, for structures that only keep indices; generation does not match when none does
+		Entity getEntity(unsigned int index);
+		unsigned int size();
+
+		//makes room for capacity entities with exactly these components, so creating them does not allocate
+		template<class... C> void reserve(unsigned int capacity)
+		{
+			Archetype &archetype = getArchetype(componentMask<C...>());
+			while (archetype.chunks.size() * archetype.chunkCapacity < capacity)
+				addChunk(archetype);
+			records.reserve(capacity);
+			freeRecords.reserve(capacity);
+		}
+
+		//null when the entity is dead or does not have the component
+		template<class T> T* get(Entity entity)
+		{
+			if (!isAlive(entity))
+				return nullptr;
+
+			Record &record = records[entity.index];
+			if ((record.archetype->mask & componentMask<T>()) == 0)
+				return nullptr;
+
+			return &record.archetype->array<T>(record.archetype->chunks[record.chunk])[record.row];
+		}
+
+		//f(count, entities, arrays...) once per chunk holding at least the components C
+		template<class... C, class F> void eachChunk(F f)
+		{
+			ComponentMask required = componentMask<C...>();
+			for (size_t a = 0; a < archetypes.size(); a++)
+			{
+				Archetype &archetype = *archetypes[a];
+				if ((archetype.mask & required) != required)
+					continue;
+
+				for (size_t c = 0; c < archetype.chunks.size() && archetype.chunks[c].count > 0; c++)
+				{
+					Chunk &chunk = archetype.chunks[c];
+					f(chunk.count, chunk.entities.data(), archetype.array<C>(chunk)...);
+				}
+			}
+		}
+
+		//f(entity, components...) for every entity holding at least the components C
+		template<class... C, class F> void each(F f)
+		{
+			eachChunk<C...>([&f](unsigned int count, Entity *entities, C*... arrays) {
+				for (unsigned int i = 0; i < count; i++)
+					f(entities[i], arrays[i]...);
+			});
+		}
+
+		//runs a system and keeps how long it took
+		template<class F> void runSystem(const char *name, F f)
+		{
+			auto start = std::chrono::steady_clock::now();
+			f();
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			timing(name).milliseconds = elapsed.count();
+		}
+
+		const std::vector<SystemTiming>& getSystemTimings();
+
+	private:
+		struct Record
+		{
+			unsigned int generation;
+			Archetype *archetype;
+			unsigned int chunk;
+			unsigned int row;
+		};
+
+		std::vector<Record> records;
+		std::vector<unsigned int> freeRecords;
+		std::vector<Archetype*> archetypes;
+		std::vector<SystemTiming> timings;
+		unsigned int alive;
+
+		Archetype& getArchetype(ComponentMask mask);
+		void addChunk(Archetype &archetype);
+		Entity allocate(Archetype &archetype);
+		SystemTiming& timing(const char *name);
+};
@@ -0,0 +1,35 @@
+#include "instanceBuffer.h"
+
+InstanceBuffer::InstanceBuffer()
+{
+	id = 0;
+	capacity = 0;
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (id != 0)
+		glDeleteBuffers(1, &id);
+}
+
+void InstanceBuffer::upload(const void* data, size_t size)
+{
+	if (id == 0)
+		glGenBuffers(1, &id);
+
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+
+	//grow by doubling so a slowly rising instance count does not keep changing the size
+	if (size > capacity)
+		capacity = capacity * 2 > size ? capacity * 2 : size;
+
+	glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint InstanceBuffer::getId()
+{
+	return id;
+}
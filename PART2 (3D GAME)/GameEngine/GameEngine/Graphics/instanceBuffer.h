@@ -0,0 +1,18 @@
+#pragma once
+#include <glew.h>
+
+//per-instance data rewritten every frame; each upload orphans the old store so the driver
+//hands out fresh memory instead of waiting for the draws still reading last frame's data
+class InstanceBuffer
+{
+	private:
+		GLuint id;
+		size_t capacity;
+
+	public:
+		InstanceBuffer();
+		~InstanceBuffer();
+
+		void upload(const void* data, size_t size);
+		GLuint getId();
+};
@@ -0,0 +1,141 @@
+#include "uploadRing.h"
+
+//offsets of compressed blocks and rows stay aligned
+static const size_t regionAlignment = 16;
+
+UploadRing::UploadRing(size_t capacity)
+{
+	this->capacity = capacity;
+	firstSequence = 0;
+	head = 0;
+	mapped = nullptr;
+	persistent = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	if (persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, capacity, NULL, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, capacity, flags);
+		persistent = mapped != nullptr;
+	}
+	if (!persistent)
+	{
+		staging.resize(capacity);
+		mapped = staging.data();
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+UploadRing::~UploadRing()
+{
+	for (size_t i = 0; i < allocations.size(); i++)
+		if (allocations[i].fence)
+			glDeleteSync(allocations[i].fence);
+
+	if (persistent)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &buffer);
+}
+
+bool UploadRing::allocate(size_t size, UploadRegion &region)
+{
+	size = (size + regionAlignment - 1) / regionAlignment * regionAlignment;
+	if (size == 0 || size > capacity)
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	//free space is after head up to the end and before the oldest live region, or between head and the
+	//oldest live region once the ring has wrapped
+	size_t offset;
+	if (allocations.empty())
+		offset = 0;
+	else
+	{
+		size_t tail = allocations.front().offset;
+		if (head > tail && capacity - head >= size)
+			offset = head;
+		else if (head > tail && tail >= size)
+			offset = 0;
+		else if (head <= tail && tail - head >= size)
+			offset = head;
+		else
+			return false;
+	}
+
+	Allocation allocation = { offset, size, false, 0 };
+	allocations.push_back(allocation);
+	head = offset + size;
+
+	region.ring = this;
+	region.sequence = firstSequence + allocations.size() - 1;
+	region.offset = offset;
+	region.size = size;
+	region.data = mapped + offset;
+	return true;
+}
+
+const void *UploadRing::bind(const UploadRegion &region)
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	if (persistent)
+		return (const void*)region.offset;
+
+	//a fresh store for every upload, the driver keeps the old one alive for the copies still reading it
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, region.size, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, region.size, region.data);
+	return (const void*)0;
+}
+
+void UploadRing::release(const UploadRegion &region)
+{
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (region.ring != this || region.sequence < firstSequence || region.sequence - firstSequence >= allocations.size())
+		return;
+
+	//the fallback has copied the pixels out already
+	Allocation &allocation = allocations[region.sequence - firstSequence];
+	if (!allocation.released && persistent)
+		allocation.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	allocation.released = true;
+}
+
+void UploadRing::retire()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	while (!allocations.empty() && allocations.front().released)
+	{
+		Allocation &front = allocations.front();
+		if (front.fence)
+		{
+			GLenum status = glClientWaitSync(front.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+			glDeleteSync(front.fence);
+		}
+
+		allocations.pop_front();
+		firstSequence++;
+	}
+
+	if (allocations.empty())
+		head = 0;
+}
+
+bool UploadRing::isPersistent()
+{
+	return persistent;
+}
+
+size_t UploadRing::getCapacity()
+{
+	return capacity;
+}
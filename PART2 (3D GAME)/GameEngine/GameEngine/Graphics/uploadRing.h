@@ -0,0 +1,66 @@
+#pragma once
+#include <glew.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class UploadRing;
+
+//a piece of the upload ring a worker writes pixels into; ring is null when nothing was allocated
+struct UploadRegion
+{
+	UploadRing *ring = nullptr;
+	unsigned long long sequence = 0;
+	size_t offset = 0;
+	size_t size = 0;
+	unsigned char *data = nullptr;
+};
+
+//staging memory for texture uploads in a pixel unpack buffer, handed out front to back and wrapping around;
+//with ARB_buffer_storage the buffer stays mapped and workers write straight into it, a fence per region tells
+//when the GPU has copied it out; without it workers write into client memory that is copied into an orphaned
+//buffer at upload time, so the GL thread never waits on a region the GPU still reads
+class UploadRing
+{
+	public:
+		//has to be created and destroyed on the thread that owns the GL context
+		UploadRing(size_t capacity);
+		~UploadRing();
+
+		UploadRing(const UploadRing &) = delete;
+		UploadRing &operator=(const UploadRing &) = delete;
+
+		//any thread; false when the ring has no room left, the caller then keeps the pixels in client memory
+		bool allocate(size_t size, UploadRegion &region);
+
+		//GL thread: binds the unpack buffer, the return value is what to pass as the pixels of glTexSubImage2D
+		//and friends for the start of the region
+		const void *bind(const UploadRegion &region);
+		//GL thread: unbinds and fences the region; also frees regions that were never bound
+		void release(const UploadRegion &region);
+		//GL thread: makes the regions the GPU is done with available again, oldest first
+		void retire();
+
+		bool isPersistent();
+		size_t getCapacity();
+
+	private:
+		struct Allocation
+		{
+			size_t offset;
+			size_t size;
+			bool released;
+			GLsync fence;
+		};
+
+		GLuint buffer;
+		size_t capacity;
+		unsigned char *mapped;                  //persistent mapping, or the client memory of the fallback
+		std::vector<unsigned char> staging;
+		bool persistent;
+
+		std::mutex mutex;
+		std::deque<Allocation> allocations;     //live regions in allocation order
+		unsigned long long firstSequence;       //sequence of allocations.front()
+		size_t head;                            //where the next region starts
+};
@@ -72,6 +72,11 @@ void Window::update()
 	glfwSwapBuffers(window);
 }
 
+void Window::setVSync(bool enabled)
+{
+	glfwSwapInterval(enabled ? 1 : 0);
+}
+
 void Window::clear()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -31,6 +31,8 @@ class Window
 		void init();
 		void update();
 		void clear();
+		//waits for the display before swapping when enabled, otherwise frames are drawn as fast as possible
+		void setVSync(bool enabled);
 
 		void setKey(int key, bool ok);
 		void setMouseButton(int button, bool ok);
@@ -0,0 +1,64 @@
+#include "cpuFeatures.h"
+#include <atomic>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void cpuid(int leaf, unsigned int registers[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)registers, leaf, 0);
+#else
+	__cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+//the register state the OS saves on a thread switch
+static unsigned long long osSavedState()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+	__asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((unsigned long long)high << 32) | low;
+#endif
+}
+
+static SimdLevel detectSimdLevel()
+{
+	unsigned int registers[4];
+	cpuid(0, registers);
+	unsigned int maxLeaf = registers[0];
+
+	cpuid(1, registers);
+	bool osxsave = (registers[2] & (1u << 27)) != 0;
+	bool avx = (registers[2] & (1u << 28)) != 0;
+	bool fma = (registers[2] & (1u << 12)) != 0;
+
+	//ymm registers are only usable when the OS saves the sse and avx halves of them
+	if (!osxsave || !avx || (osSavedState() & 6) != 6)
+		return SIMD_SSE2;
+
+	if (maxLeaf < 7)
+		return SIMD_AVX;
+	cpuid(7, registers);
+	bool avx2 = (registers[1] & (1u << 5)) != 0;
+	return avx2 && fma ? SIMD_AVX2 : SIMD_AVX;
+}
+
+static std::atomic<int> simdLimit(SIMD_AVX2);
+
+SimdLevel getSimdLevel()
+{
+	static const SimdLevel detected = detectSimdLevel();
+	int limit = simdLimit.load(std::memory_order_relaxed);
+	return detected < limit ? detected : (SimdLevel)limit;
+}
+
+void limitSimdLevel(SimdLevel level)
+{
+	simdLimit.store(level, std::memory_order_relaxed);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+//vector instruction sets the kernels can pick from, each one includes the ones before it;
+//AVX2 here also means FMA, the two came together on every processor that has them
+enum SimdLevel
+{
+	SIMD_SSE2,
+	SIMD_AVX,
+	SIMD_AVX2
+};
+
+//the best level both the processor and the OS support, checked once; the AVX kernels are built in
+//their own files with the matching /arch and are only called when this allows it
+SimdLevel getSimdLevel();
+//caps what getSimdLevel returns from now on, so benchmarks can compare a kernel against the older paths
+void limitSimdLevel(SimdLevel level);
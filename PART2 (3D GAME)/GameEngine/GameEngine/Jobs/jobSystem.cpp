@@ -0,0 +1,181 @@
+#include "jobSystem.h"
+
+//queue of the calling thread, threads that do not belong to the job system use the main thread's
+static thread_local unsigned int threadIndex = 0;
+
+JobCounter::JobCounter()
+{
+	pending = 0;
+}
+
+bool JobCounter::isDone()
+{
+	return pending.load() == 0;
+}
+
+JobSystem::JobSystem(unsigned int workers)
+{
+	queued = 0;
+	sleeping = 0;
+	stopping = false;
+
+	if (workers == 0)
+		workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (unsigned int i = 0; i <= workers; i++)
+		queues.push_back(new Queue());
+
+	threadIndex = 0;
+	for (unsigned int i = 1; i <= workers; i++)
+		this->workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	for (size_t i = 0; i < queues.size(); i++)
+		delete queues[i];
+}
+
+unsigned int JobSystem::getThreadCount()
+{
+	return queues.size();
+}
+
+void JobSystem::run(std::function<void()> job, JobCounter *counter)
+{
+	if (counter)
+		counter->pending++;
+	push(Job{ std::move(job), counter });
+}
+
+void JobSystem::runAfter(JobCounter &dependency, std::function<void()> job, JobCounter *counter)
+{
+	if (counter)
+		counter->pending++;
+
+	//the job that finishes the dependency takes the waiting list under the same lock
+	{
+		std::lock_guard<std::mutex> lock(dependency.waitingMutex);
+		if (dependency.pending.load() != 0)
+		{
+			dependency.waiting.push_back(JobCounter::Waiting{ std::move(job), counter });
+			return;
+		}
+	}
+	push(Job{ std::move(job), counter });
+}
+
+void JobSystem::push(Job job)
+{
+	Queue &queue = *queues[threadIndex < queues.size() ? threadIndex : 0];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queued++;
+
+	//a worker going to sleep counts itself before it checks queued, so one of the two sees the other
+	if (sleeping.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+}
+
+//newest job of our own queue first (still in cache), otherwise the oldest of someone else's
+bool JobSystem::next(Job &job)
+{
+	unsigned int own = threadIndex < queues.size() ? threadIndex : 0;
+	{
+		Queue &queue = *queues[own];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			queued--;
+			return true;
+		}
+	}
+
+	for (unsigned int i = 1; i < queues.size(); i++)
+	{
+		Queue &queue = *queues[(own + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Job &job)
+{
+	job.function();
+	if (!job.counter)
+		return;
+
+	//the waiter may return as soon as pending reaches zero, so nothing touches the counter after that
+	std::vector<JobCounter::Waiting> ready;
+	{
+		std::lock_guard<std::mutex> lock(job.counter->waitingMutex);
+		if (job.counter->pending.load() == 1)
+			ready.swap(job.counter->waiting);
+		job.counter->pending--;
+	}
+
+	for (size_t i = 0; i < ready.size(); i++)
+		push(Job{ std::move(ready[i].function), ready[i].counter });
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+	while (!counter.isDone())
+	{
+		Job job;
+		if (next(job))
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+
+	//the last job may still be inside the counter's lock
+	std::lock_guard<std::mutex> lock(counter.waitingMutex);
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+	threadIndex = index;
+
+	while (true)
+	{
+		Job job;
+		if (next(job))
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping++;
+		wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+		sleeping--;
+		if (stopping)
+			return;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//counts the jobs started with it that have not finished yet; must outlive them
+class JobCounter
+{
+	public:
+		JobCounter();
+
+		bool isDone();
+
+	private:
+		struct Waiting
+		{
+			std::function<void()> function;
+			JobCounter *counter;
+		};
+
+		std::atomic<int> pending;
+		std::mutex waitingMutex;
+		std::vector<Waiting> waiting;
+
+		friend class JobSystem;
+};
+
+//work stealing scheduler: every thread pushes and pops its own deque from the back,
+//idle threads steal from the front of the others; the main thread is thread 0 and only runs jobs while it waits
+class JobSystem
+{
+	public:
+		//workers == 0 leaves one core for the main thread
+		JobSystem(unsigned int workers = 0);
+		~JobSystem();
+
+		//the counter, when given, is only done once the job has finished
+		void run(std::function<void()> job, JobCounter *counter = nullptr);
+		//job is started once dependency is done
+		void runAfter(JobCounter &dependency, std::function<void()> job, JobCounter *counter = nullptr);
+
+		//f(begin, end) over [0, count) in ranges of at least grain, a few ranges per thread so stealing can even out the load
+		template<class F> void parallelFor(unsigned int count, unsigned int grain, F f, JobCounter &counter)
+		{
+			grain = std::max(1u, grain);
+			unsigned int ranges = std::min((count + grain - 1) / grain, getThreadCount() * 4);
+			for (unsigned int r = 0; r < ranges; r++)
+			{
+				unsigned int begin = (unsigned int)((unsigned long long)count * r / ranges);
+				unsigned int end = (unsigned int)((unsigned long long)count * (r + 1) / ranges);
+				run([f, begin, end]() { f(begin, end); }, &counter);
+			}
+		}
+
+		//runs queued jobs on the calling thread until the counter is done
+		void wait(JobCounter &counter);
+
+		//workers plus the main thread
+		unsigned int getThreadCount();
+
+	private:
+		struct Job
+		{
+			std::function<void()> function;
+			JobCounter *counter;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::thread> workers;
+		std::vector<Queue*> queues;
+		std::atomic<int> queued;
+		std::atomic<int> sleeping;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		std::atomic<bool> stopping;
+
+		void push(Job job);
+		bool next(Job &job);
+		void execute(Job &job);
+		void workerLoop(unsigned int index);
+};
@@ -0,0 +1,265 @@
+#include "assetLoader.h"
+#include <chrono>
+
+MeshHandle::MeshHandle()
+{
+}
+
+bool MeshHandle::isReady() const
+{
+	return slot && slot->ready;
+}
+
+Mesh &MeshHandle::get()
+{
+	return slot->mesh;
+}
+
+//small octahedron standing in for meshes that are not loaded yet
+static Mesh createPlaceholderMesh()
+{
+	std::vector<Vertex> vertices = {
+		Vertex(1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.5f),
+		Vertex(-1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.5f, 0.5f),
+		Vertex(0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.25f, 1.0f),
+		Vertex(0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.25f, 0.0f),
+		Vertex(0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.75f, 0.5f),
+		Vertex(0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.5f)
+	};
+	std::vector<int> indices = {
+		0, 2, 4,  4, 2, 1,  1, 2, 5,  5, 2, 0,
+		4, 3, 0,  1, 3, 4,  5, 3, 1,  0, 3, 5
+	};
+
+	return Mesh(vertices, indices);
+}
+
+AssetLoader::AssetLoader(unsigned int workers, size_t uploadCapacity, size_t stagingBytes) : uploads(uploadCapacity), ring(stagingBytes)
+{
+	stopping = false;
+	pending = 0;
+	jobSystem = nullptr;
+	placeholderMesh = createPlaceholderMesh();
+
+	if (workers == 0)
+		workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (unsigned int i = 0; i < workers; i++)
+		this->workers.push_back(std::thread(&AssetLoader::workerLoop, this));
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		stopping = true;
+	}
+	jobsReady.notify_all();
+
+	//workers blocked on a full upload queue give up once stopping is set
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void AssetLoader::submit(Task job)
+{
+	pending++;
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		jobs.push_back(std::move(job));
+	}
+	jobsReady.notify_one();
+}
+
+//hands a finished job to the GL thread, waiting while the queue is full
+void AssetLoader::queueUpload(Task upload)
+{
+	while (!uploads.tryPush(std::move(upload)))
+	{
+		if (stopping)
+			return;
+		std::this_thread::yield();
+	}
+}
+
+void AssetLoader::workerLoop()
+{
+	while (true)
+	{
+		Task job;
+		{
+			std::unique_lock<std::mutex> lock(jobsMutex);
+			jobsReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		job();
+	}
+}
+
+//faces are the six cubemap faces or the layers of an array
+static GLuint createPlaceholderTexture(GLenum target, int faces)
+{
+	//1x1 rows are padded to 4 bytes
+	std::vector<unsigned char> grey(faces * 4, 128);
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(target, textureID);
+
+	if (target == GL_TEXTURE_2D_ARRAY)
+		glTexImage3D(target, 0, GL_RGB, 1, 1, faces, 0, GL_RGB, GL_UNSIGNED_BYTE, grey.data());
+	else
+		for (int i = 0; i < faces; i++)
+		{
+			GLenum face = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + i : target;
+			glTexImage2D(face, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, grey.data());
+		}
+
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	return textureID;
+}
+
+TextureHandle AssetLoader::loadTexture(const std::string &filename)
+{
+	TextureHandle texture;
+	if (textures.find(filename, texture))
+		return texture;
+
+	texture = textures.insert(filename, createPlaceholderTexture(GL_TEXTURE_2D, 1));
+
+	//the upload holds on to the handle, so the texture cannot be evicted before it is filled in
+	submit([this, filename, texture]() {
+		std::shared_ptr<TextureData> image = std::make_shared<TextureData>();
+		if (!decodeTexture(filename.c_str(), *image, true, &ring))
+		{
+			std::cout << "Texture failed to load at path: " << filename << std::endl;
+			pending--;
+			return;
+		}
+
+		queueUpload([this, image, texture]() {
+			uploadTexture(texture.getId(), *image);
+			textures.setSize(texture, textureSize(*image));
+			pending--;
+		});
+	});
+
+	return texture;
+}
+
+//the budget sees every face or layer, a 1500x1500 RGBA skybox alone is over 50 MB
+TextureHandle AssetLoader::loadCubemap(const std::vector<std::string> &faces)
+{
+	TextureHandle texture;
+	if (textures.find(faces, GL_TEXTURE_CUBE_MAP, texture))
+		return texture;
+
+	texture = textures.insert(faces, GL_TEXTURE_CUBE_MAP, createPlaceholderTexture(GL_TEXTURE_CUBE_MAP, 6));
+
+	submit([this, faces, texture]() {
+		std::shared_ptr<std::vector<TextureData>> images = std::make_shared<std::vector<TextureData>>();
+		decodeCubemap(faces, *images, &ring);
+
+		queueUpload([this, images, texture]() {
+			uploadCubemap(texture.getId(), *images);
+			textures.setSize(texture, cubemapSize(*images));
+			pending--;
+		});
+	});
+
+	return texture;
+}
+
+TextureHandle AssetLoader::loadTextureArray(const std::vector<std::string> &layers)
+{
+	TextureHandle texture;
+	if (textures.find(layers, GL_TEXTURE_2D_ARRAY, texture))
+		return texture;
+
+	texture = textures.insert(layers, GL_TEXTURE_2D_ARRAY, createPlaceholderTexture(GL_TEXTURE_2D_ARRAY, std::max<int>(1, (int)layers.size())));
+
+	submit([this, layers, texture]() {
+		std::shared_ptr<std::vector<TextureData>> images = std::make_shared<std::vector<TextureData>>();
+		decodeTextureArray(layers, *images, &ring);
+
+		queueUpload([this, images, texture]() {
+			uploadTextureArray(texture.getId(), *images);
+			textures.setSize(texture, textureArraySize(*images));
+			pending--;
+		});
+	});
+
+	return texture;
+}
+
+MeshHandle AssetLoader::loadMesh(const std::string &filename, std::vector<Texture> textures)
+{
+	MeshHandle handle;
+	handle.slot = std::make_shared<MeshHandle::Slot>();
+	handle.slot->mesh = placeholderMesh;
+	handle.slot->mesh.setTextures(textures);
+	handle.slot->ready = false;
+
+	std::shared_ptr<MeshHandle::Slot> slot = handle.slot;
+	submit([this, filename, textures, slot]() {
+		MeshLoaderObj loader;
+		loader.setJobSystem(jobSystem);
+		std::shared_ptr<MeshData> data = std::make_shared<MeshData>();
+		//loadObjData has already said why, the handle keeps drawing the placeholder
+		if (!loader.loadObjData(filename, *data))
+		{
+			pending--;
+			return;
+		}
+
+		queueUpload([this, data, textures, slot]() {
+			slot->mesh = MeshLoaderObj::createMesh(*data);
+			slot->mesh.setTextures(textures);
+			slot->ready = true;
+			pending--;
+		});
+	});
+
+	return handle;
+}
+
+void AssetLoader::setJobSystem(JobSystem *jobs)
+{
+	jobSystem = jobs;
+}
+
+void AssetLoader::processUploads(double budgetMs)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	//regions of earlier uploads the GPU has finished copying are free for the workers again
+	ring.retire();
+
+	Task upload;
+	while (uploads.tryPop(upload))
+	{
+		upload();
+		upload = nullptr;
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= budgetMs)
+			break;
+	}
+}
+
+bool AssetLoader::isIdle() const
+{
+	return pending == 0;
+}
+
+TextureCache &AssetLoader::getTextureCache()
+{
+	return textures;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mesh.h"
+#include "meshLoaderObj.h"
+#include "texture.h"
+#include "textureCache.h"
+#include "boundedQueue.h"
+#include "..\Graphics\uploadRing.h"
+
+//a mesh that is still being loaded, it draws as a placeholder until it has been uploaded
+class MeshHandle
+{
+	public:
+		MeshHandle();
+
+		bool isReady() const;
+		Mesh &get();
+
+	private:
+		struct Slot
+		{
+			Mesh mesh;
+			bool ready;
+		};
+		std::shared_ptr<Slot> slot;
+
+		friend class AssetLoader;
+};
+
+//reads and decodes assets on worker threads, the GL uploads are queued and done on the main thread
+class AssetLoader
+{
+	public:
+		//workers == 0 leaves one core for the main thread; stagingBytes is the size of the pixel buffer ring
+		//the workers decode textures into, images that do not fit are uploaded from client memory
+		AssetLoader(unsigned int workers = 0, size_t uploadCapacity = 64, size_t stagingBytes = 64 * 1024 * 1024);
+		~AssetLoader();
+
+		//the texture id is valid right away and shows a 1x1 placeholder until the image is uploaded;
+		//a file that is already loaded (or loading) gives the same texture again; a .ktx2 or .dds next to the
+		//file is loaded instead when the driver supports its block compression
+		TextureHandle loadTexture(const std::string &filename);
+		//six face images, or one KTX2/DDS cubemap; cached like loadTexture under the list of files
+		TextureHandle loadCubemap(const std::vector<std::string> &faces);
+		//a GL_TEXTURE_2D_ARRAY with one layer per image, all of the same size; cached under the list of files
+		TextureHandle loadTextureArray(const std::vector<std::string> &layers);
+
+		MeshHandle loadMesh(const std::string &filename, std::vector<Texture> textures = std::vector<Texture>());
+		//large models are parsed in chunks on this job system instead of on one worker; set before loading meshes
+		void setJobSystem(JobSystem *jobs);
+
+		//runs queued uploads on the calling (GL) thread until the time budget is spent, at least one per call
+		void processUploads(double budgetMs);
+
+		//true when nothing is being decoded or waiting to be uploaded
+		bool isIdle() const;
+
+		TextureCache &getTextureCache();
+
+	private:
+		typedef std::function<void()> Task;
+
+		std::vector<std::thread> workers;
+		std::deque<Task> jobs;
+		std::mutex jobsMutex;
+		std::condition_variable jobsReady;
+		std::atomic<bool> stopping;
+
+		BoundedQueue<Task> uploads;
+		std::atomic<int> pending;
+
+		JobSystem *jobSystem;
+		Mesh placeholderMesh;
+		TextureCache textures;
+		UploadRing ring;
+
+		void submit(Task job);
+		void queueUpload(Task upload);
+		void workerLoop();
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//fixed capacity lock-free queue, any number of producers and consumers (Vyukov's bounded MPMC queue)
+//capacity has to be a power of two
+template <typename T>
+class BoundedQueue
+{
+	public:
+		BoundedQueue(size_t capacity) : cells(capacity), mask(capacity - 1)
+		{
+			for (size_t i = 0; i < capacity; i++)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+
+			enqueuePos.store(0, std::memory_order_relaxed);
+			dequeuePos.store(0, std::memory_order_relaxed);
+		}
+
+		//returns false when the queue is full
+		bool tryPush(T &&value)
+		{
+			size_t pos = enqueuePos.load(std::memory_order_relaxed);
+			Cell *cell;
+
+			while (true)
+			{
+				cell = &cells[pos & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+				if (diff == 0)
+				{
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+
+			cell->value = std::move(value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		//returns false when the queue is empty
+		bool tryPop(T &value)
+		{
+			size_t pos = dequeuePos.load(std::memory_order_relaxed);
+			Cell *cell;
+
+			while (true)
+			{
+				cell = &cells[pos & mask];
+				size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+				if (diff == 0)
+				{
+					if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false;
+				else
+					pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+
+			value = std::move(cell->value);
+			cell->sequence.store(pos + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::vector<Cell> cells;
+		size_t mask;
+
+		//producers and consumers each get their own cache line
+		alignas(64) std::atomic<size_t> enqueuePos;
+		alignas(64) std::atomic<size_t> dequeuePos;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+//64-bit hash of a block of memory (MurmurHash64A), used to tell when a source asset has changed
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+
+	const unsigned char *bytes = (const unsigned char*)data;
+	const unsigned char *blocksEnd = bytes + (size & ~(size_t)7);
+	uint64_t h = seed ^ (size * m);
+
+	for (; bytes != blocksEnd; bytes += 8)
+	{
+		uint64_t k;
+		memcpy(&k, bytes, 8);
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
+	}
+
+	switch (size & 7)
+	{
+		case 7: h ^= (uint64_t)bytes[6] << 48; [[fallthrough]];
+		case 6: h ^= (uint64_t)bytes[5] << 40; [[fallthrough]];
+		case 5: h ^= (uint64_t)bytes[4] << 32; [[fallthrough]];
+		case 4: h ^= (uint64_t)bytes[3] << 24; [[fallthrough]];
+		case 3: h ^= (uint64_t)bytes[2] << 16; [[fallthrough]];
+		case 2: h ^= (uint64_t)bytes[1] << 8; [[fallthrough]];
+		case 1: h ^= (uint64_t)bytes[0];
+			h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+
+	return h;
+}
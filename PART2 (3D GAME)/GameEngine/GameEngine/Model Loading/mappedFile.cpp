@@ -0,0 +1,137 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	view = nullptr;
+	length = 0;
+	opened = false;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#else
+	fd = -1;
+#endif
+}
+
+MappedFile::MappedFile(const std::string &filename) : MappedFile()
+{
+	open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+
+	//an empty file cannot be mapped, but it is still a valid (empty) file
+	if (length > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+		{
+			close();
+			return false;
+		}
+
+		view = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			close();
+			return false;
+		}
+	}
+#else
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)st.st_size;
+
+	if (length > 0)
+	{
+		void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		madvise(address, length, MADV_SEQUENTIAL);
+		view = (const char*)address;
+	}
+#endif
+
+	opened = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (view)
+		UnmapViewOfFile(view);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (view)
+		munmap((void*)view, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+#endif
+	view = nullptr;
+	length = 0;
+	opened = false;
+}
+
+bool MappedFile::isOpen() const
+{
+	return opened;
+}
+
+const char *MappedFile::data() const
+{
+	return view;
+}
+
+size_t MappedFile::size() const
+{
+	return length;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+//read-only view of a whole file mapped into memory
+class MappedFile
+{
+	public:
+		MappedFile();
+		MappedFile(const std::string &filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		bool open(const std::string &filename);
+		void close();
+
+		bool isOpen() const;
+		const char *data() const;
+		size_t size() const;
+
+	private:
+		const char *view;
+		size_t length;
+		bool opened;
+#ifdef _WIN32
+		void *file;
+		void *mapping;
+#else
+		int fd;
+#endif
+};
@@ -0,0 +1,40 @@
+#include "material.h"
+
+Material::Material()
+{
+	positionScale = positionOffset = textureScale = textureOffset = octahedralNormals = -1;
+}
+
+Material::Material(Shader &shader, const Mesh &mesh)
+{
+	unsigned int diffuseNr = 1;
+	unsigned int specularNr = 1;
+	unsigned int normalNr = 1;
+	unsigned int heightNr = 1;
+	unsigned int arrayNr = 1;
+
+	//samplers are named after the texture type and how many of that type came before
+	for (unsigned int i = 0; i < mesh.textures.size(); i++)
+	{
+		std::string number;
+		std::string name = mesh.textures[i].type;
+		if (name == "texture_diffuse")
+			number = std::to_string(diffuseNr++);
+		else if (name == "texture_specular")
+			number = std::to_string(specularNr++);
+		else if (name == "texture_normal")
+			number = std::to_string(normalNr++);
+		else if (name == "texture_height")
+			number = std::to_string(heightNr++);
+		else if (name == "texture_array")
+			number = std::to_string(arrayNr++);
+
+		samplerLocations.push_back(shader.getUniformLocation(name + number));
+	}
+
+	positionScale = shader.getUniformLocation("positionScale");
+	positionOffset = shader.getUniformLocation("positionOffset");
+	textureScale = shader.getUniformLocation("textureScale");
+	textureOffset = shader.getUniformLocation("textureOffset");
+	octahedralNormals = shader.getUniformLocation("octahedralNormals");
+}
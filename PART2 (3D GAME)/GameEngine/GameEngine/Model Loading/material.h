@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "..\Shaders\shader.h"
+#include "mesh.h"
+
+//everything a mesh needs from a shader to draw, resolved once per (shader, mesh) pair
+//so drawing only binds integers: texture i goes to unit i and its sampler location
+class Material
+{
+	public:
+		std::vector<int> samplerLocations;
+
+		//dequantization of packed vertices, see VertexQuantization
+		int positionScale;
+		int positionOffset;
+		int textureScale;
+		int textureOffset;
+		int octahedralNormals;
+
+		Material();
+		Material(Shader &shader, const Mesh &mesh);
+};
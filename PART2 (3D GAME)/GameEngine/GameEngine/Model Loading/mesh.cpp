@@ -1,4 +1,25 @@
 #include "mesh.h"
+#include "material.h"
+#include <algorithm>
+
+void computeBounds(const Vertex *vertices, unsigned int vertexCount, glm::vec3 &boundsMin, glm::vec3 &boundsMax)
+{
+	boundsMin = boundsMax = glm::vec3(0.0f);
+	if (vertexCount == 0)
+		return;
+
+	boundsMin = boundsMax = vertices[0].pos;
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[i].pos);
+		boundsMax = glm::max(boundsMax, vertices[i].pos);
+	}
+}
+
+bool fitsShortIndices(unsigned int vertexCount)
+{
+	return vertexCount <= 0xFFFF;
+}
 
 Mesh::Mesh() {}
 
@@ -6,8 +27,28 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices)
 {
 	this->vertices = vertices;
 	this->indices = indices;
+	computeBounds(vertices.data(), vertices.size(), boundsMin, boundsMax);
+
+	setup();
+}
+
+//uploads straight from memory the mesh does not own (e.g. a mapped .meshbin), no CPU copy is kept
+Mesh::Mesh(const Vertex *vertices, unsigned int vertexCount, const int *indices, unsigned int indexCount, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, VertexFormat format)
+{
+	this->boundsMin = boundsMin;
+	this->boundsMax = boundsMax;
+
+	setup(vertices, vertexCount, indices, indexCount, format);
+}
+
+//the packing was done before, e.g. on a loader thread or when the .meshbin was written
+Mesh::Mesh(const void *vertices, unsigned int vertexCount, VertexFormat format, const VertexQuantization &quantization,
+	const void *indices, unsigned int indexCount, GLenum indexType, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	this->boundsMin = boundsMin;
+	this->boundsMax = boundsMax;
 
-	setup2();
+	setup(vertices, vertexCount, format, quantization, indices, indexCount, indexType);
 }
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures)
@@ -15,39 +56,72 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<T
 	this->vertices = vertices;
 	this->indices = indices;
 	this->textures = textures;
+	computeBounds(vertices.data(), vertices.size(), boundsMin, boundsMax);
 
 	setup();
 }
 
-// render the mesh
-void Mesh::draw(Shader shader)
+void Mesh::bindMaterial(const Material &material)
 {
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	unsigned int heightNr = 1;
-
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); 
-											
-		std::string number;
-		std::string name = textures[i].type;
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularNr++); 
-		else if (name == "texture_normal")
-			number = std::to_string(normalNr++);
-		else if (name == "texture_height")
-			number = std::to_string(heightNr++); 
-
-		glUniform1i(glGetUniformLocation(shader.getId(), (name + number).c_str()), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+		glActiveTexture(GL_TEXTURE0 + i);
+		if (i < material.samplerLocations.size())
+			glUniform1i(material.samplerLocations[i], i);
+		glBindTexture(textures[i].target, textures[i].id);
 	}
 
+	//undo the vertex quantization in the shader
+	glUniform3fv(material.positionScale, 1, &quantization.positionScale[0]);
+	glUniform3fv(material.positionOffset, 1, &quantization.positionOffset[0]);
+	glUniform2fv(material.textureScale, 1, &quantization.textureScale[0]);
+	glUniform2fv(material.textureOffset, 1, &quantization.textureOffset[0]);
+	glUniform1i(material.octahedralNormals, vertexFormat != VERTEX_FLOAT);
+}
+
+// render the mesh
+void Mesh::draw(const Material &material, unsigned int lod)
+{
+	bindMaterial(material);
+
 	glBindVertexArray(vao);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+	const MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	glDrawElements(GL_TRIANGLES, level.indexCount, indexType, (void*)(level.indexOffset * indexSize));
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::drawInstanced(const Material &material, unsigned int lod, GLuint instanceBuffer, unsigned int firstInstance, unsigned int instanceCount, GLuint layerBuffer)
+{
+	if (instanceCount == 0)
+		return;
+
+	bindMaterial(material);
+
+	//the instance attributes are pointed at firstInstance on every call, GL 3.3 has no base instance
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(3 + column);
+		glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(3 + column, 1);
+	}
+	if (layerBuffer)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, layerBuffer);
+		glEnableVertexAttribArray(7);
+		glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(firstInstance * sizeof(float)));
+		glVertexAttribDivisor(7, 1);
+	}
+	else
+		glDisableVertexAttribArray(7);
+
+	const MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	glDrawElementsInstanced(GL_TRIANGLES, level.indexCount, indexType, (void*)(level.indexOffset * indexSize), instanceCount);
 	glBindVertexArray(0);
 
 	glActiveTexture(GL_TEXTURE0);
@@ -55,6 +129,39 @@ void Mesh::draw(Shader shader)
 
 void Mesh::setup()
 {
+	setup(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+void Mesh::setup(const Vertex *vertexData, unsigned int vertexCount, const int *indexData, unsigned int indexCount, VertexFormat format)
+{
+	std::vector<PackedVertex> packed;
+	VertexQuantization packing;
+	packVertices(vertexData, vertexCount, format, packed, packing);
+
+	if (fitsShortIndices(vertexCount))
+	{
+		std::vector<unsigned short> shortIndices(indexData, indexData + indexCount);
+		setup(format == VERTEX_FLOAT ? (const void*)vertexData : packed.data(), vertexCount, format, packing, shortIndices.data(), indexCount, GL_UNSIGNED_SHORT);
+	}
+	else
+		setup(format == VERTEX_FLOAT ? (const void*)vertexData : packed.data(), vertexCount, format, packing, indexData, indexCount, GL_UNSIGNED_INT);
+}
+
+void Mesh::setup(const void *vertexData, unsigned int vertexCount, VertexFormat format, const VertexQuantization &quantization,
+	const void *indexData, unsigned int indexCount, GLenum indexType)
+{
+	this->indexCount = indexCount;
+	this->indexType = indexType;
+	this->vertexFormat = format;
+	this->quantization = quantization;
+
+	//without a lod chain the whole index buffer is the only level
+	if (lods.empty())
+	{
+		MeshLod full = { 0, indexCount, 0.0f };
+		lods.push_back(full);
+	}
+
 	//create buffers
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
@@ -63,48 +170,70 @@ void Mesh::setup()
 	//bind buffers
 	glBindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertexCount * vertexStride(format), vertexData, GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * indexSize, indexData, GL_STATIC_DRAW);
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	if (format == VERTEX_FLOAT)
+	{
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
 
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normals));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normals));
 
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoords));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, textureCoords));
+	}
+	else
+	{
+		//snorm16 positions are left unnormalized, positionScale already divides by 32767
+		glEnableVertexAttribArray(0);
+		if (format == VERTEX_HALF)
+			glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+		else
+			glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, textureCoords));
+	}
 
 	glBindVertexArray(0);
 }
 
-//no textures yet
-void Mesh::setup2()
+void Mesh::setLods(std::vector<MeshLod> lods)
 {
-	glGenVertexArrays(1, &vao);
-	glGenBuffers(1, &vbo);
-	glGenBuffers(1, &ibo);
-
-	glBindVertexArray(vao);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	if (!lods.empty())
+		this->lods = lods;
+}
 
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+unsigned int Mesh::selectLod(float distance, float scale, float pixelsPerUnit, float maxPixels) const
+{
+	if (distance <= 0.0f)
+		return 0;
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	float pixelsPerModelUnit = scale * pixelsPerUnit / distance;
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	unsigned int lod = 0;
+	for (unsigned int i = 1; i < lods.size(); i++)
+	{
+		if (lods[i].error * pixelsPerModelUnit > maxPixels)
+			break;
+		lod = i;
+	}
 
-	glBindVertexArray(0);
+	return lod;
 }
 
+//the buffers are already uploaded, the textures are only bound when drawing
 void Mesh::setTextures(std::vector<Texture> textures)
 {
 	this->textures = textures;
-	setup();
 }
 
 Mesh::~Mesh() {}
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <vector>
 #include "..\Shaders\shader.h"
+#include "vertexFormat.h"
 
 struct Vertex 
 {
@@ -58,12 +59,29 @@ struct Vertex
 	}
 };
 
+class Material;
+
 struct Texture 
 {
 	unsigned int id;
 	std::string type;
+	GLenum target = GL_TEXTURE_2D; //GL_TEXTURE_2D_ARRAY for "texture_array", sampled with a per instance layer
+};
+
+//one level of detail: a range of the index buffer and how far (in model units) it strays from the full mesh
+struct MeshLod
+{
+	unsigned int indexOffset;
+	unsigned int indexCount;
+	float error;
 };
 
+//axis aligned bounds of the vertex positions
+void computeBounds(const Vertex *vertices, unsigned int vertexCount, glm::vec3 &boundsMin, glm::vec3 &boundsMax);
+
+//16 bit indices are enough up to 65535 vertices (indices 0 to 0xFFFE), 0xFFFF stays free for primitive restart
+bool fitsShortIndices(unsigned int vertexCount);
+
 class Mesh
 {
 	public:
@@ -72,15 +90,38 @@ class Mesh
 		std::vector<Texture> textures;
 
 		unsigned int vao, vbo, ibo;
+		unsigned int indexCount;
+		GLenum indexType; //GL_UNSIGNED_SHORT when every vertex fits in 16 bits
+		VertexFormat vertexFormat;
+		VertexQuantization quantization;
+		glm::vec3 boundsMin, boundsMax;
+		std::vector<MeshLod> lods;
 
 		Mesh();	
 		Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures);
 		Mesh(std::vector<Vertex> vertices, std::vector<int> indices);
+		Mesh(const Vertex *vertices, unsigned int vertexCount, const int *indices, unsigned int indexCount, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, VertexFormat format = VERTEX_FLOAT);
+		//vertices already in format (Vertex or PackedVertex) and indices already of indexType, uploaded as they are
+		Mesh(const void *vertices, unsigned int vertexCount, VertexFormat format, const VertexQuantization &quantization,
+			const void *indices, unsigned int indexCount, GLenum indexType, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
 		~Mesh();
 
 		void setTextures(std::vector<Texture> textures);
+		void setLods(std::vector<MeshLod> lods);
 		void setup();
-		void setup2();
-		void draw(Shader shader);
+		void setup(const Vertex *vertexData, unsigned int vertexCount, const int *indexData, unsigned int indexCount, VertexFormat format = VERTEX_FLOAT);
+		void setup(const void *vertexData, unsigned int vertexCount, VertexFormat format, const VertexQuantization &quantization,
+			const void *indexData, unsigned int indexCount, GLenum indexType);
+		void draw(const Material &material, unsigned int lod = 0);
+		//draws instanceCount copies, each with a model matrix read from instanceBuffer at attribute locations 3-6
+		//and, given a layerBuffer, a float texture array layer at location 7
+		void drawInstanced(const Material &material, unsigned int lod, GLuint instanceBuffer, unsigned int firstInstance, unsigned int instanceCount, GLuint layerBuffer = 0);
+
+		//coarsest level whose error, seen from distance at the given scale, stays under maxPixels on screen
+		//pixelsPerUnit is the size in pixels of one unit at distance 1 (projection[1][1] * viewport height / 2)
+		unsigned int selectLod(float distance, float scale, float pixelsPerUnit, float maxPixels = 1.0f) const;
+
+	private:
+		void bindMaterial(const Material &material);
 };
 
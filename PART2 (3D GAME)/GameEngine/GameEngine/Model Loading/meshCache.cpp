@@ -0,0 +1,138 @@
+#include "meshCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(MeshCacheHeader) == 112, "MeshCacheHeader is written to disk as is");
+
+static const char meshCacheMagic[4] = { 'M', 'B', 'I', 'N' };
+
+static unsigned int indexSizeFor(unsigned int vertexCount)
+{
+	return fitsShortIndices(vertexCount) ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+//the lods follow the indices at the next multiple of 4 bytes
+static size_t lodsOffset(const MeshCacheHeader &header)
+{
+	size_t offset = sizeof(MeshCacheHeader) + (size_t)header.vertexCount * header.vertexSize + (size_t)header.indexCount * header.indexSize;
+	return (offset + 3) & ~(size_t)3;
+}
+
+MeshCache::MeshCache()
+{
+	header = nullptr;
+}
+
+bool MeshCache::open(const std::string &filename, uint64_t sourceHash)
+{
+	close();
+
+	if (!file.open(filename) || file.size() < sizeof(MeshCacheHeader))
+	{
+		file.close();
+		return false;
+	}
+
+	const MeshCacheHeader *candidate = (const MeshCacheHeader*)file.data();
+	if (memcmp(candidate->magic, meshCacheMagic, 4) != 0 ||
+		candidate->version != MESH_CACHE_VERSION ||
+		candidate->sourceHash != sourceHash ||
+		candidate->vertexFormat > VERTEX_SNORM16 ||
+		candidate->vertexSize != vertexStride((VertexFormat)candidate->vertexFormat) ||
+		candidate->indexSize != indexSizeFor(candidate->vertexCount) ||
+		file.size() != lodsOffset(*candidate) + (size_t)candidate->lodCount * sizeof(MeshLod))
+	{
+		file.close();
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+void MeshCache::close()
+{
+	file.close();
+	header = nullptr;
+}
+
+bool MeshCache::isOpen() const
+{
+	return header != nullptr;
+}
+
+const MeshCacheHeader &MeshCache::getHeader() const
+{
+	return *header;
+}
+
+const void *MeshCache::getVertices() const
+{
+	return file.data() + sizeof(MeshCacheHeader);
+}
+
+const void *MeshCache::getIndices() const
+{
+	return file.data() + sizeof(MeshCacheHeader) + (size_t)header->vertexCount * header->vertexSize;
+}
+
+const MeshLod *MeshCache::getLods() const
+{
+	return (const MeshLod*)(file.data() + lodsOffset(*header));
+}
+
+//"Resources/Models/sphere.obj" -> "Resources/Models/sphere.meshbin"
+std::string MeshCache::pathFor(const std::string &sourceFilename)
+{
+	size_t dot = sourceFilename.find_last_of('.');
+	size_t slash = sourceFilename.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return sourceFilename + ".meshbin";
+
+	return sourceFilename.substr(0, dot) + ".meshbin";
+}
+
+bool MeshCache::write(const std::string &filename, uint64_t sourceHash, VertexFormat format, const VertexQuantization &quantization,
+	const void *vertices, unsigned int vertexCount, const void *indices, unsigned int indexCount,
+	const std::vector<MeshLod> &lods, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	MeshCacheHeader header = {};
+	memcpy(header.magic, meshCacheMagic, 4);
+	header.version = MESH_CACHE_VERSION;
+	header.sourceHash = sourceHash;
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.vertexFormat = format;
+	header.vertexSize = vertexStride(format);
+	header.indexSize = indexSizeFor(vertexCount);
+	header.lodCount = lods.size();
+	header.boundsMin = boundsMin;
+	header.boundsMax = boundsMax;
+	header.quantization = quantization;
+
+	//write to a temporary file first so a crash never leaves a half written cache behind
+	std::string temporary = filename + ".tmp";
+	std::ofstream out(temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!out.good())
+		return false;
+
+	size_t indexEnd = sizeof(header) + (size_t)vertexCount * header.vertexSize + (size_t)indexCount * header.indexSize;
+	const char padding[4] = {};
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)vertices, (size_t)vertexCount * header.vertexSize);
+	out.write((const char*)indices, (size_t)indexCount * header.indexSize);
+	out.write(padding, lodsOffset(header) - indexEnd);
+	out.write((const char*)lods.data(), lods.size() * sizeof(MeshLod));
+	out.close();
+
+	if (!out.good())
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(temporary.c_str(), filename.c_str()) == 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm.hpp>
+#include "mappedFile.h"
+#include "mesh.h"
+
+//bump whenever the layout of a .meshbin or the mesh pipeline output changes
+#define MESH_CACHE_VERSION 4
+
+//start of a .meshbin file, followed by vertexCount vertices as they are uploaded, indexCount indices
+//of indexSize bytes padded to a multiple of 4 bytes, and lodCount lods
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;        //of the obj contents, seeded with the loader settings
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t vertexFormat;      //VertexFormat the vertices are packed in
+	uint32_t vertexSize;
+	uint32_t indexSize;         //2 when every vertex fits in 16 bit indices, else 4
+	uint32_t lodCount;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	VertexQuantization quantization;
+	uint32_t padding[2];
+};
+
+//binary copy of a loaded model, stored beside its source file and mapped back in on later runs
+class MeshCache
+{
+	public:
+		MeshCache();
+
+		//maps the cache file, fails if it is missing, truncated or was built from a different source or with other settings
+		bool open(const std::string &filename, uint64_t sourceHash);
+		void close();
+		bool isOpen() const;
+
+		const MeshCacheHeader &getHeader() const;
+		//Vertex or PackedVertex depending on the header's vertexFormat
+		const void *getVertices() const;
+		//unsigned short or unsigned int depending on the header's indexSize
+		const void *getIndices() const;
+		const MeshLod *getLods() const;
+
+		static std::string pathFor(const std::string &sourceFilename);
+		//vertices already packed in format, indices already narrowed to 16 bits when the vertex count fits them
+		static bool write(const std::string &filename, uint64_t sourceHash, VertexFormat format, const VertexQuantization &quantization,
+			const void *vertices, unsigned int vertexCount, const void *indices, unsigned int indexCount,
+			const std::vector<MeshLod> &lods, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+
+	private:
+		MappedFile file;
+		const MeshCacheHeader *header;
+};
@@ -1,69 +1,134 @@
 #include "meshLoaderObj.h"
-#include "stringTokenizer.h"
-
-MeshLoaderObj::MeshLoaderObj() {};
-
-Mesh MeshLoaderObj::loadObj(const std::string &filename)
+#include "mappedFile.h"
+#include "meshCache.h"
+#include "contentHash.h"
+#include "meshSimplifier.h"
+#include "meshOptimizer.h"
+#include "objScanner.h"
+#include "..\Jobs\jobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+//a face corner, as indices into the position, texcoord and normal lists
+struct ObjCorner
 {
-	std::vector<Vertex> vertices;
-	std::vector<int> indices;
+	int p, t, n;
 
-	//Reading Obj file
-	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
-	if (!file.good())
+	bool operator==(const ObjCorner &other) const
 	{
-		std::cout << "Obj model not found " << filename << std::endl;
-		std::terminate();
+		return p == other.p && t == other.t && n == other.n;
 	}
+};
 
-	std::string line;
-	std::vector<std::string> tokens, facetokens;
+struct ObjCornerHash
+{
+	size_t operator()(const ObjCorner &corner) const
+	{
+		size_t h = (size_t)corner.p * 0x9E3779B1u;
+		h ^= (size_t)corner.t * 0x85EBCA77u + (h << 6) + (h >> 2);
+		h ^= (size_t)corner.n * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+		return h;
+	}
+};
 
+//a face as read from the file, its corners are resolved once every chunk has been read
+struct ObjFace
+{
+	unsigned int format;
+	unsigned int firstCorner;
+	unsigned int cornerCount;
+
+	//how many positions, texcoords and normals the chunk had read before this face,
+	//negative (relative) indices are counted back from there
+	unsigned int positionsBefore;
+	unsigned int texcoordsBefore;
+	unsigned int normalsBefore;
+};
+
+//everything read from one newline aligned slice of an obj file
+struct ObjChunk
+{
 	std::vector<glm::vec3> positions;
-	positions.reserve(1000);
-
 	std::vector<glm::vec3> normals;
-	normals.reserve(1000);
-
 	std::vector<glm::vec2> texcoords;
-	texcoords.reserve(1000);
+	std::vector<ObjFace> faces;
+	std::vector<int> corners; //3 raw indices per corner, as written in the file
+};
+
+//obj files below this size are not worth splitting into jobs
+static const size_t minChunkSize = 1 << 20;
+
+static void scanObjChunk(const char *begin, const char *end, ObjChunk &chunk)
+{
+	size_t expectedLines = (end - begin) / 32;
+	chunk.positions.reserve(expectedLines / 4);
+	chunk.normals.reserve(expectedLines / 4);
+	chunk.texcoords.reserve(expectedLines / 4);
+	chunk.faces.reserve(expectedLines / 4);
+
+	const char *cursor = begin;
 
 	//Parsing obj file
-	while (std::getline(file, line))
+	while (cursor < end)
 	{
-		_stringTokenize(line, tokens);
+		std::string_view line = _nextLine(cursor, end);
+		const char *token = line.data();
+		const char *lineEnd = token + line.size();
 
-		if (tokens.size() == 0)
-			continue;
+		std::string_view keyword = _nextToken(token, lineEnd);
 
-		//Comments
-		if (tokens.size()>0 && tokens[0].at(0) == '#')
+		//Empty lines and comments
+		if (keyword.empty() || keyword[0] == '#')
 			continue;
 
-		//Vertices
-		if (tokens.size()>3 && tokens[0] == "v")
-			positions.push_back(glm::vec3(_stringToFloat(tokens[1]), _stringToFloat(tokens[2]), _stringToFloat(tokens[3])));
-
-		//Normals
-		if (tokens.size()>3 && tokens[0] == "vn")
-			normals.push_back(glm::vec3(_stringToFloat(tokens[1]), _stringToFloat(tokens[2]), _stringToFloat(tokens[3])));
+		//Vertices and normals
+		if (keyword == "v" || keyword == "vn")
+		{
+			std::string_view x = _nextToken(token, lineEnd);
+			std::string_view y = _nextToken(token, lineEnd);
+			std::string_view z = _nextToken(token, lineEnd);
+			if (z.empty())
+				continue;
+
+			glm::vec3 value(_parseFloat(x), _parseFloat(y), _parseFloat(z));
+			if (keyword == "v")
+				chunk.positions.push_back(value);
+			else
+				chunk.normals.push_back(value);
+		}
 
 		//Texture Coords
-		if (tokens.size()>2 && tokens[0] == "vt")
-			texcoords.push_back(glm::vec2(_stringToFloat(tokens[1]), _stringToFloat(tokens[2])));
+		else if (keyword == "vt")
+		{
+			std::string_view u = _nextToken(token, lineEnd);
+			std::string_view v = _nextToken(token, lineEnd);
+			if (v.empty())
+				continue;
+
+			chunk.texcoords.push_back(glm::vec2(_parseFloat(u), _parseFloat(v)));
+		}
 
 		//Faces
-		if (tokens.size() >= 4 && tokens[0] == "f")
+		else if (keyword == "f")
 		{
+			//a face needs at least 3 more tokens on the line
+			const char *firstCorner = token;
+			std::string_view first = _nextToken(token, lineEnd);
+			if (_nextToken(token, lineEnd).empty() || _nextToken(token, lineEnd).empty())
+				continue;
+			token = firstCorner;
+
+			int values[3];
 			unsigned int face_format = 0;
-			if (tokens[1].find("//") != std::string::npos) face_format = 3;
-			_faceTokenize(tokens[1], facetokens);
+			if (first.find("//") != std::string_view::npos) face_format = 3;
+			int parts = _parseFaceCorner(first, values);
 
-			if (facetokens.size() == 3)
+			if (parts == 3)
 				face_format = 4;
 			else
 			{
-				if (facetokens.size() == 2)
+				if (parts == 2)
 				{
 					if (face_format != 3) face_format = 2;
 				}
@@ -73,88 +138,398 @@ Mesh MeshLoaderObj::loadObj(const std::string &filename)
 				}
 			}
 
-			unsigned int index_of_first_vertex_of_face = -1;
+			ObjFace face;
+			face.format = face_format;
+			face.firstCorner = chunk.corners.size() / 3;
+			face.cornerCount = 0;
+			face.positionsBefore = chunk.positions.size();
+			face.texcoordsBefore = chunk.texcoords.size();
+			face.normalsBefore = chunk.normals.size();
 
-			for (unsigned int num_token = 1; num_token<tokens.size(); num_token++)
+			while (true)
 			{
-				if (tokens[num_token].at(0) == '#') break;
-				_faceTokenize(tokens[num_token], facetokens);
+				std::string_view corner = _nextToken(token, lineEnd);
+				if (corner.empty() || corner[0] == '#') break;
+				_parseFaceCorner(corner, values);
+
+				chunk.corners.push_back(values[0]);
+				chunk.corners.push_back(values[1]);
+				chunk.corners.push_back(values[2]);
+				face.cornerCount++;
+			}
 
-				if (face_format == 1) //Just pos
-				{
-					int p_index = _stringToInt(facetokens[0]);
-					if (p_index>0) p_index -= 1;
-					else p_index = positions.size() + p_index;
+			if (face.cornerCount > 0)
+				chunk.faces.push_back(face);
+		}
+	}
+}
 
-					vertices.push_back(Vertex(positions[p_index].x, positions[p_index].y, positions[p_index].z));
-				}
-				else if (face_format == 2) //Pos and texcoords
-				{
-					int p_index = _stringToInt(facetokens[0]);
-					if (p_index>0) p_index -= 1;
-					else p_index = positions.size() + p_index;
+//splits [begin, end) into at most count slices that each end right after a '\n'
+static std::vector<const char*> splitObjChunks(const char *begin, const char *end, unsigned int count)
+{
+	std::vector<const char*> bounds;
+	bounds.push_back(begin);
 
-					int t_index = _stringToInt(facetokens[1]);
-					if (t_index>0) t_index -= 1;
-					else t_index = texcoords.size() + t_index;
+	size_t size = end - begin;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		const char *split = begin + size * i / count;
+		if (split <= bounds.back())
+			continue;
 
-					vertices.push_back(Vertex(positions[p_index].x, positions[p_index].y, positions[p_index].z, texcoords[t_index].x, texcoords[t_index].y));
-				}
-				else if (face_format == 3)
-				{ 
-					//Pos and normal
-					int p_index = _stringToInt(facetokens[0]);
-					if (p_index>0) p_index -= 1;
-					else p_index = positions.size() + p_index;
-
-					int n_index = _stringToInt(facetokens[1]);
-					if (n_index>0) n_index -= 1;
-					else n_index = normals.size() + n_index;
-
-					vertices.push_back(Vertex(positions[p_index].x, positions[p_index].y, positions[p_index].z, normals[n_index].x, normals[n_index].y, normals[n_index].z));
-				}
-				else
+		const char *newline = (const char*)memchr(split, '\n', end - split);
+		if (newline == nullptr)
+			break;
+		if (newline + 1 < end)
+			bounds.push_back(newline + 1);
+	}
+
+	bounds.push_back(end);
+	return bounds;
+}
+
+//obj indices are 1-based, negative ones count back from what was read before the face;
+//false for 0 and for anything outside the count attributes read from the whole file
+static bool resolveObjIndex(int index, unsigned int base, unsigned int before, size_t count, int &resolved)
+{
+	long long position = index > 0 ? (long long)index - 1 : (long long)base + before + index;
+	if (index == 0 || position < 0 || position >= (long long)count)
+		return false;
+
+	resolved = (int)position;
+	return true;
+}
+
+const void *MeshData::getVertexData() const
+{
+	if (cache.isOpen())
+		return cache.getVertices();
+	return format == VERTEX_FLOAT ? (const void*)vertices.data() : packedVertices.data();
+}
+
+const void *MeshData::getIndexData() const
+{
+	if (cache.isOpen())
+		return cache.getIndices();
+	return fitsShortIndices(vertices.size()) ? (const void*)shortIndices.data() : indices.data();
+}
+
+unsigned int MeshData::getVertexCount() const
+{
+	return cache.isOpen() ? cache.getHeader().vertexCount : vertices.size();
+}
+
+unsigned int MeshData::getIndexCount() const
+{
+	return cache.isOpen() ? cache.getHeader().indexCount : indices.size();
+}
+
+GLenum MeshData::getIndexType() const
+{
+	return fitsShortIndices(getVertexCount()) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+std::vector<MeshLod> MeshData::getLods() const
+{
+	if (cache.isOpen())
+		return std::vector<MeshLod>(cache.getLods(), cache.getLods() + cache.getHeader().lodCount);
+	return lods;
+}
+
+MeshLoaderObj::MeshLoaderObj()
+{
+	jobs = nullptr;
+	parseChunks = 0;
+	lodLevels = 5;
+	vertexFormat = VERTEX_SNORM16;
+	readCache = true;
+	log = &std::cout;
+}
+
+void MeshLoaderObj::setJobSystem(JobSystem *jobs)
+{
+	this->jobs = jobs;
+}
+
+void MeshLoaderObj::setParseChunks(unsigned int chunks)
+{
+	parseChunks = chunks;
+}
+
+void MeshLoaderObj::setLodLevels(unsigned int levels)
+{
+	lodLevels = std::max(1u, levels);
+}
+
+void MeshLoaderObj::setVertexFormat(VertexFormat format)
+{
+	vertexFormat = format;
+}
+
+void MeshLoaderObj::setReadCache(bool read)
+{
+	readCache = read;
+}
+
+void MeshLoaderObj::setLog(std::ostream *log)
+{
+	this->log = log;
+}
+
+uint64_t MeshLoaderObj::getSettingsHash() const
+{
+	uint32_t settings[3] = { MESH_CACHE_VERSION, lodLevels, (uint32_t)vertexFormat };
+	return hashBytes(settings, sizeof(settings));
+}
+
+bool MeshLoaderObj::parseObj(const char *begin, const char *end, std::vector<Vertex> &vertices, std::vector<int> &indices, size_t *cornerCount)
+{
+	unsigned int chunkCount = parseChunks;
+	if (chunkCount == 0)
+	{
+		chunkCount = jobs ? jobs->getThreadCount() : 1;
+		chunkCount = (unsigned int)std::min<size_t>(chunkCount, std::max<size_t>(1, (end - begin) / minChunkSize));
+	}
+
+	//one job per chunk on the shared job system, so loading never starts threads of its own next to its workers
+	std::vector<const char*> bounds = splitObjChunks(begin, end, chunkCount);
+	std::vector<ObjChunk> chunks(bounds.size() - 1);
+	if (jobs && chunks.size() > 1)
+	{
+		JobCounter scanned;
+		jobs->parallelFor((unsigned int)chunks.size(), 1, [&](unsigned int first, unsigned int last) {
+			for (unsigned int i = first; i < last; i++)
+				scanObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+		}, scanned);
+		jobs->wait(scanned);
+	}
+	else
+	{
+		for (size_t i = 0; i < chunks.size(); i++)
+			scanObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+	}
+
+	//gather the attribute lists in file order, remembering where each chunk starts
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+	std::vector<unsigned int> positionBase, normalBase, texcoordBase;
+	size_t corners = 0;
+	if (cornerCount)
+		*cornerCount = 0;
+
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		positionBase.push_back(positions.size());
+		normalBase.push_back(normals.size());
+		texcoordBase.push_back(texcoords.size());
+
+		positions.insert(positions.end(), chunks[i].positions.begin(), chunks[i].positions.end());
+		normals.insert(normals.end(), chunks[i].normals.begin(), chunks[i].normals.end());
+		texcoords.insert(texcoords.end(), chunks[i].texcoords.begin(), chunks[i].texcoords.end());
+		corners += chunks[i].corners.size() / 3;
+	}
+
+	//face corners seen so far and the vertex each distinct one was given
+	std::unordered_map<ObjCorner, int, ObjCornerHash> vertexOfCorner;
+	vertexOfCorner.reserve(corners / 2);
+	vertices.reserve(corners / 2);
+	indices.reserve(corners * 3 / 2);
+
+	//resolve the faces in file order, so the result does not depend on the number of chunks
+	for (size_t c = 0; c < chunks.size(); c++)
+	{
+		const ObjChunk &chunk = chunks[c];
+
+		for (size_t f = 0; f < chunk.faces.size(); f++)
+		{
+			const ObjFace &face = chunk.faces[f];
+			int index_of_first_vertex_of_face = -1;
+			int index_of_previous_vertex = -1;
+
+			for (unsigned int num_token = 1; num_token <= face.cornerCount; num_token++)
+			{
+				const int *values = &chunk.corners[(face.firstCorner + num_token - 1) * 3];
+
+				//resolve the corner to its (position, texcoord, normal) triplet, -1 for what the format lacks
+				ObjCorner corner = { -1, -1, -1 };
+				bool valid = resolveObjIndex(values[0], positionBase[c], face.positionsBefore, positions.size(), corner.p);
+				if (face.format == 2)
+					valid = valid && resolveObjIndex(values[1], texcoordBase[c], face.texcoordsBefore, texcoords.size(), corner.t);
+				else if (face.format == 3)
+					valid = valid && resolveObjIndex(values[1], normalBase[c], face.normalsBefore, normals.size(), corner.n);
+				else if (face.format == 4)
 				{
-					//Normal and texcoord
-					int p_index = _stringToInt(facetokens[0]);
-					if (p_index>0) p_index -= 1;
-					else p_index = positions.size() + p_index;
+					valid = valid && resolveObjIndex(values[1], texcoordBase[c], face.texcoordsBefore, texcoords.size(), corner.t);
+					valid = valid && resolveObjIndex(values[2], normalBase[c], face.normalsBefore, normals.size(), corner.n);
+				}
 
-					int t_index = _stringToInt(facetokens[1]);
-					if (t_index>0) t_index -= 1;
-					else t_index = normals.size() + t_index;
+				//a broken file gives no mesh rather than part of one
+				if (!valid)
+				{
+					vertices.clear();
+					indices.clear();
+					return false;
+				}
 
-					int n_index = _stringToInt(facetokens[2]);
-					if (n_index>0) n_index -= 1;
-					else n_index = normals.size() + n_index;
+				//identical corners share one vertex
+				auto welded = vertexOfCorner.emplace(corner, (int)vertices.size());
+				int index = welded.first->second;
 
-					vertices.push_back(Vertex(positions[p_index].x, positions[p_index].y, positions[p_index].z, normals[n_index].x, normals[n_index].y, normals[n_index].z, texcoords[t_index].x, texcoords[t_index].y));
+				if (welded.second)
+				{
+					const glm::vec3 &p = positions[corner.p];
+
+					if (face.format == 1) //Just pos
+					{
+						vertices.push_back(Vertex(p.x, p.y, p.z));
+					}
+					else if (face.format == 2) //Pos and texcoords
+					{
+						const glm::vec2 &t = texcoords[corner.t];
+
+						vertices.push_back(Vertex(p.x, p.y, p.z, t.x, t.y));
+					}
+					else if (face.format == 3) //Pos and normal
+					{
+						const glm::vec3 &n = normals[corner.n];
+
+						vertices.push_back(Vertex(p.x, p.y, p.z, n.x, n.y, n.z));
+					}
+					else //Pos, texcoord and normal
+					{
+						const glm::vec2 &t = texcoords[corner.t];
+						const glm::vec3 &n = normals[corner.n];
+
+						vertices.push_back(Vertex(p.x, p.y, p.z, n.x, n.y, n.z, t.x, t.y));
+					}
 				}
 
+				//n-gons are split into a triangle fan around their first corner
 				if (num_token<4)
 				{
 					if (num_token == 1)
-						index_of_first_vertex_of_face = vertices.size() - 1;
+						index_of_first_vertex_of_face = index;
 
-					indices.push_back(vertices.size() - 1);
+					indices.push_back(index);
 				}
 				else
 				{
 					indices.push_back(index_of_first_vertex_of_face);
-					indices.push_back(vertices.size() - 2);
-					indices.push_back(vertices.size() - 1);
+					indices.push_back(index_of_previous_vertex);
+					indices.push_back(index);
 				}
+				index_of_previous_vertex = index;
 			}
 		}
 	}
 
-	std::cout << "Loading:  " << filename << std::endl;
+	if (cornerCount)
+		*cornerCount = corners;
+	return true;
+}
+
+bool MeshLoaderObj::loadObjData(const std::string &filename, MeshData &data)
+{
+	auto start = std::chrono::steady_clock::now();
+	data.format = vertexFormat;
+
+	//Reading Obj file
+	MappedFile file(filename);
+	if (!file.isOpen())
+	{
+		*log << "Obj model not found " << filename << std::endl;
+		return false;
+	}
+
+	//Binary cache from an earlier run, used as long as neither the obj nor the settings have changed since
+	uint64_t sourceHash = hashBytes(file.data(), file.size(), getSettingsHash());
+	std::string cacheFilename = MeshCache::pathFor(filename);
+
+	if (readCache && data.cache.open(cacheFilename, sourceHash))
+	{
+		data.format = (VertexFormat)data.cache.getHeader().vertexFormat;
+		data.quantization = data.cache.getHeader().quantization;
+		data.boundsMin = data.cache.getHeader().boundsMin;
+		data.boundsMax = data.cache.getHeader().boundsMax;
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		*log << "Loading:  " << cacheFilename << " (" << elapsed.count() << " ms)" << std::endl;
+
+		return true;
+	}
+
+	size_t corners = 0;
+	bool parsed = parseObj(file.data(), file.data() + file.size(), data.vertices, data.indices, &corners);
+	file.close();
+
+	if (!parsed)
+	{
+		*log << "Obj model has a face index out of range " << filename << std::endl;
+		return false;
+	}
+
+	//nothing to draw, and no lod chain to reorder
+	if (data.indices.empty())
+	{
+		*log << "Obj model has no faces " << filename << std::endl;
+		return false;
+	}
+
+	computeBounds(data.vertices.data(), data.vertices.size(), data.boundsMin, data.boundsMax);
+	buildLodChain(data.vertices, data.indices, data.lods, lodLevels);
+
+	//reorder every lod for the post-transform cache and overdraw, then the vertices for fetching
+	VertexCacheStats before = analyzeVertexCache(data.indices.data(), data.lods[0].indexCount, data.vertices.size());
+	for (size_t i = 0; i < data.lods.size(); i++)
+	{
+		int *lodIndices = data.indices.data() + data.lods[i].indexOffset;
+		optimizeVertexCache(lodIndices, data.lods[i].indexCount, data.vertices.size());
+		optimizeOverdraw(lodIndices, data.lods[i].indexCount, data.vertices);
+	}
+	optimizeVertexFetch(data.vertices, data.indices);
+	VertexCacheStats after = analyzeVertexCache(data.indices.data(), data.lods[0].indexCount, data.vertices.size());
+
+	//pack here rather than on the GL thread, the .meshbin keeps the packed layout for the next run
+	packVertices(data.vertices.data(), data.vertices.size(), data.format, data.packedVertices, data.quantization);
+	if (fitsShortIndices(data.vertices.size()))
+		data.shortIndices.assign(data.indices.begin(), data.indices.end());
+
+	if (!MeshCache::write(cacheFilename, sourceHash, data.format, data.quantization, data.getVertexData(), data.getVertexCount(),
+		data.getIndexData(), data.getIndexCount(), data.lods, data.boundsMin, data.boundsMax))
+		*log << "Could not write mesh cache " << cacheFilename << std::endl;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	*log << "Loading:  " << filename << " (" << elapsed.count() << " ms)" << std::endl;
+	*log << "          " << corners << " face corners welded into " << data.vertices.size() << " vertices" << std::endl;
+	*log << "          lod triangles:";
+	for (size_t i = 0; i < data.lods.size(); i++)
+		*log << " " << data.lods[i].indexCount / 3;
+	*log << std::endl;
+	*log << "          acmr " << before.acmr << " -> " << after.acmr << ", atvr " << before.atvr << " -> " << after.atvr << std::endl;
+
+	return true;
+}
 
-	Mesh mesh(vertices, indices);
+Mesh MeshLoaderObj::createMesh(const MeshData &data)
+{
+	Mesh mesh(data.getVertexData(), data.getVertexCount(), data.format, data.quantization,
+		data.getIndexData(), data.getIndexCount(), data.getIndexType(), data.boundsMin, data.boundsMax);
+	mesh.setLods(data.getLods());
 
 	return mesh;
 }
 
+Mesh MeshLoaderObj::loadObj(const std::string &filename)
+{
+	MeshData data;
+	//loadObjData has already said why
+	if (!loadObjData(filename, data))
+		std::terminate();
+
+	return createMesh(data);
+}
+
 Mesh MeshLoaderObj::loadObj(const std::string &filename, std::vector<Texture> textures)
 {
 	Mesh mesh = loadObj(filename);
@@ -162,5 +537,3 @@ Mesh MeshLoaderObj::loadObj(const std::string &filename, std::vector<Texture> te
 
 	return mesh;
 }
-
-
@@ -7,6 +7,32 @@
 #include <gtc\matrix_transform.hpp>
 #include <gtc\type_ptr.hpp>
 #include "mesh.h"
+#include "meshCache.h"
+
+class JobSystem;
+
+//a model read into memory but not uploaded yet, either parsed from text or mapped from its .meshbin;
+//either way it is already in the layout the GL thread uploads as is
+struct MeshData
+{
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+	std::vector<MeshLod> lods;
+	glm::vec3 boundsMin, boundsMax;
+	VertexFormat format;
+	//vertices packed in format (unused for VERTEX_FLOAT) and indices narrowed to 16 bits when they fit
+	std::vector<PackedVertex> packedVertices;
+	std::vector<unsigned short> shortIndices;
+	VertexQuantization quantization;
+	MeshCache cache;
+
+	const void *getVertexData() const;
+	const void *getIndexData() const;
+	unsigned int getVertexCount() const;
+	unsigned int getIndexCount() const;
+	GLenum getIndexType() const;
+	std::vector<MeshLod> getLods() const;
+};
 
 class MeshLoaderObj
 {
@@ -14,5 +40,40 @@ class MeshLoaderObj
 		MeshLoaderObj();
 		Mesh loadObj(const std::string &filename, std::vector<Texture> textures);
 		Mesh loadObj(const std::string &filename);
+
+		//CPU side of loadObj, safe to call from any thread
+		bool loadObjData(const std::string &filename, MeshData &data);
+		//GL side of loadObj, has to run on the thread that owns the context
+		static Mesh createMesh(const MeshData &data);
+
+		//large files are scanned in chunks that run as jobs on this system, and the calling thread helps while
+		//it waits; without one every chunk is scanned on the calling thread
+		void setJobSystem(JobSystem *jobs);
+		//chunks a file is split into, 0 picks one per job system thread for files large enough to be worth it
+		void setParseChunks(unsigned int chunks);
+		//levels of detail built for every mesh, the first one being the full mesh
+		void setLodLevels(unsigned int levels);
+		//layout the meshes are uploaded in
+		void setVertexFormat(VertexFormat format);
+		//false parses the obj even when its .meshbin is up to date, and writes the cache again
+		void setReadCache(bool read);
+		//where progress and errors are written, std::cout unless set
+		void setLog(std::ostream *log);
+
+		//everything besides the obj itself that changes what loadObjData produces; the hash a .meshbin is
+		//checked against is seeded with it, so a cache built with other settings is rebuilt
+		uint64_t getSettingsHash() const;
+
+		//just the text parse and welding of loadObjData, without the cache, lods or reordering;
+		//false, with nothing output, when a face refers to an attribute the file does not have
+		bool parseObj(const char *begin, const char *end, std::vector<Vertex> &vertices, std::vector<int> &indices, size_t *cornerCount = nullptr);
+
+	private:
+		JobSystem *jobs;
+		unsigned int parseChunks;
+		unsigned int lodLevels;
+		VertexFormat vertexFormat;
+		bool readCache;
+		std::ostream *log;
 };
 
@@ -0,0 +1,291 @@
+#include "meshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+VertexCacheStats analyzeVertexCache(const int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats = { 0.0f, 0.0f };
+	if (indexCount < 3)
+		return stats;
+
+	//a FIFO cache only needs to know when each vertex was last put in it
+	std::vector<size_t> insertedAt(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	size_t misses = 0;
+	size_t distinct = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		int v = indices[i];
+		if (!used[v])
+		{
+			used[v] = true;
+			distinct++;
+		}
+
+		if (insertedAt[v] == 0 || misses + 1 - insertedAt[v] > cacheSize)
+		{
+			misses++;
+			insertedAt[v] = misses;
+		}
+	}
+
+	stats.acmr = (float)misses / (indexCount / 3);
+	stats.atvr = (float)misses / distinct;
+	return stats;
+}
+
+//Forsyth's vertex scoring, tuned for a cache of 32 entries
+static const int forsythCacheSize = 32;
+
+static float vertexScore(int cachePosition, int liveTriangles)
+{
+	if (liveTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		//the triangle just drawn used the first three entries, keep them equally attractive
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = powf(1.0f - (float)(cachePosition - 3) / (forsythCacheSize - 3), 1.5f);
+	}
+
+	//favour vertices with few triangles left so they leave the mesh early
+	return score + 2.0f / sqrtf((float)liveTriangles);
+}
+
+void optimizeVertexCache(int *indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2)
+		return;
+
+	//vertex -> live triangles, in CSR form; each vertex's range shrinks as its triangles are emitted
+	std::vector<int> liveTriangles(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		liveTriangles[indices[i]]++;
+
+	std::vector<int> adjacencyOffset(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+	std::vector<int> adjacency(triangleCount * 3);
+	std::vector<int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[indices[i]]++] = (int)(i / 3);
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scoreOfVertex(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		scoreOfVertex[v] = vertexScore(-1, liveTriangles[v]);
+
+	std::vector<float> scoreOfTriangle(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	int bestTriangle = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const int *tri = &indices[t * 3];
+		scoreOfTriangle[t] = scoreOfVertex[tri[0]] + scoreOfVertex[tri[1]] + scoreOfVertex[tri[2]];
+		if (scoreOfTriangle[t] > scoreOfTriangle[bestTriangle])
+			bestTriangle = (int)t;
+	}
+
+	std::vector<int> result;
+	result.reserve(triangleCount * 3);
+	std::vector<int> cache, nextCache;
+	size_t scanCursor = 0;
+
+	while (result.size() < triangleCount * 3)
+	{
+		//nothing in the cache has triangles left, continue with the next triangle not drawn yet
+		if (bestTriangle < 0)
+		{
+			while (emitted[scanCursor])
+				scanCursor++;
+			bestTriangle = (int)scanCursor;
+		}
+
+		const int *tri = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+
+		for (int c = 0; c < 3; c++)
+		{
+			int v = tri[c];
+			result.push_back(v);
+
+			//remove the triangle from the vertex's live list
+			int end = adjacencyOffset[v] + liveTriangles[v];
+			for (int k = adjacencyOffset[v]; k < end; k++)
+			{
+				if (adjacency[k] == bestTriangle)
+				{
+					adjacency[k] = adjacency[end - 1];
+					break;
+				}
+			}
+			liveTriangles[v]--;
+		}
+
+		//the triangle's vertices go to the front of the cache, the rest shifts back
+		nextCache.assign(tri, tri + 3);
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			int v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				nextCache.push_back(v);
+		}
+
+		for (size_t i = 0; i < nextCache.size(); i++)
+			cachePosition[nextCache[i]] = i < (size_t)forsythCacheSize ? (int)i : -1;
+
+		//rescore every vertex whose cache position changed and the triangles that use them
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < nextCache.size(); i++)
+		{
+			int v = nextCache[i];
+			scoreOfVertex[v] = vertexScore(cachePosition[v], liveTriangles[v]);
+
+			for (int k = adjacencyOffset[v]; k < adjacencyOffset[v] + liveTriangles[v]; k++)
+			{
+				int t = adjacency[k];
+				const int *other = &indices[t * 3];
+				scoreOfTriangle[t] = scoreOfVertex[other[0]] + scoreOfVertex[other[1]] + scoreOfVertex[other[2]];
+			}
+		}
+
+		for (size_t i = 0; i < nextCache.size() && i < (size_t)forsythCacheSize; i++)
+		{
+			int v = nextCache[i];
+			for (int k = adjacencyOffset[v]; k < adjacencyOffset[v] + liveTriangles[v]; k++)
+			{
+				int t = adjacency[k];
+				if (scoreOfTriangle[t] > bestScore)
+				{
+					bestScore = scoreOfTriangle[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		if (nextCache.size() > (size_t)forsythCacheSize)
+			nextCache.resize(forsythCacheSize);
+		cache.swap(nextCache);
+	}
+
+	std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeOverdraw(int *indices, size_t indexCount, const std::vector<Vertex> &vertices, float threshold)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2)
+		return;
+
+	VertexCacheStats before = analyzeVertexCache(indices, indexCount, vertices.size());
+
+	//split where the cache order starts over: a triangle with no vertex in the cache begins a cluster
+	std::vector<size_t> clusterStart;
+	{
+		std::vector<size_t> insertedAt(vertices.size(), 0);
+		size_t misses = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			int triangleMisses = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				int v = indices[t * 3 + c];
+				if (insertedAt[v] == 0 || misses + 1 - insertedAt[v] > 16)
+				{
+					misses++;
+					insertedAt[v] = misses;
+					triangleMisses++;
+				}
+			}
+			if (triangleMisses == 3 || t == 0)
+				clusterStart.push_back(t);
+		}
+	}
+	clusterStart.push_back(triangleCount);
+
+	if (clusterStart.size() <= 2)
+		return;
+
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> clusterCentroid(clusterStart.size() - 1, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormal(clusterStart.size() - 1, glm::vec3(0.0f));
+
+	for (size_t c = 0; c + 1 < clusterStart.size(); c++)
+	{
+		float clusterArea = 0.0f;
+		for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+		{
+			const glm::vec3 &p0 = vertices[indices[t * 3]].pos;
+			const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].pos;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+			glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+
+			clusterCentroid[c] += centroid * area;
+			clusterNormal[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroid[c];
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f)
+			clusterCentroid[c] /= clusterArea;
+	}
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	//clusters far out along their own normal occlude the rest from most directions, draw them first
+	std::vector<std::pair<float, size_t>> order(clusterStart.size() - 1);
+	for (size_t c = 0; c < order.size(); c++)
+	{
+		float length = glm::length(clusterNormal[c]);
+		glm::vec3 normal = length > 0.0f ? clusterNormal[c] / length : glm::vec3(0.0f);
+		order[c] = std::make_pair(-glm::dot(clusterCentroid[c] - meshCentroid, normal), c);
+	}
+	std::stable_sort(order.begin(), order.end());
+
+	std::vector<int> result;
+	result.reserve(indexCount);
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		size_t c = order[i].second;
+		result.insert(result.end(), indices + clusterStart[c] * 3, indices + clusterStart[c + 1] * 3);
+	}
+
+	//keep the new order only if it does not cost too much cache efficiency
+	VertexCacheStats after = analyzeVertexCache(result.data(), result.size(), vertices.size());
+	if (after.acmr <= before.acmr * threshold)
+		std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<int> &indices)
+{
+	std::vector<int> remap(vertices.size(), -1);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		int v = indices[i];
+		if (remap[v] < 0)
+		{
+			remap[v] = (int)reordered.size();
+			reordered.push_back(vertices[v]);
+		}
+		indices[i] = remap[v];
+	}
+
+	//vertices no triangle uses are dropped
+	vertices.swap(reordered);
+}
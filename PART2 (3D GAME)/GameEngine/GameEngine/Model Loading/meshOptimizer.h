@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+
+//post-transform cache statistics of a triangle list
+struct VertexCacheStats
+{
+	float acmr; //average cache miss ratio: vertices transformed per triangle, 0.5 is ideal for large meshes
+	float atvr; //average transformed vertex ratio: vertices transformed per distinct vertex, 1 is ideal
+};
+
+//simulates a FIFO post-transform cache of cacheSize entries
+VertexCacheStats analyzeVertexCache(const int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+//reorders triangles so recently used vertices are reused while still in the cache (Forsyth's algorithm)
+void optimizeVertexCache(int *indices, size_t indexCount, size_t vertexCount);
+
+//reorders clusters of triangles so those facing outwards are drawn first, which lets early depth
+//testing reject more of what is behind them; the cache miss ratio may grow by at most threshold
+void optimizeOverdraw(int *indices, size_t indexCount, const std::vector<Vertex> &vertices, float threshold = 1.05f);
+
+//reorders the vertex array into first use order so fetching the vertices walks memory linearly
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<int> &indices);
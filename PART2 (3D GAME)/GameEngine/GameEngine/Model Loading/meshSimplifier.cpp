@@ -0,0 +1,319 @@
+#include "meshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+//symmetric 4x4 error quadric plus the total weight of the planes it holds
+struct Quadric
+{
+	double a00, a01, a02, a03;
+	double a11, a12, a13;
+	double a22, a23;
+	double a33;
+	double weight;
+};
+
+static void addPlane(Quadric &q, const glm::vec3 &n, float d, double w)
+{
+	q.a00 += w * n.x * n.x; q.a01 += w * n.x * n.y; q.a02 += w * n.x * n.z; q.a03 += w * n.x * d;
+	q.a11 += w * n.y * n.y; q.a12 += w * n.y * n.z; q.a13 += w * n.y * d;
+	q.a22 += w * n.z * n.z; q.a23 += w * n.z * d;
+	q.a33 += w * d * d;
+	q.weight += w;
+}
+
+static void addQuadric(Quadric &q, const Quadric &other)
+{
+	q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02; q.a03 += other.a03;
+	q.a11 += other.a11; q.a12 += other.a12; q.a13 += other.a13;
+	q.a22 += other.a22; q.a23 += other.a23;
+	q.a33 += other.a33;
+	q.weight += other.weight;
+}
+
+//weighted mean squared distance from p to the planes of the quadric
+static double quadricError(const Quadric &q, const glm::vec3 &p)
+{
+	double x = p.x, y = p.y, z = p.z;
+	double r = q.a00 * x * x + 2 * q.a01 * x * y + 2 * q.a02 * x * z + 2 * q.a03 * x
+		+ q.a11 * y * y + 2 * q.a12 * y * z + 2 * q.a13 * y
+		+ q.a22 * z * z + 2 * q.a23 * z
+		+ q.a33;
+
+	return q.weight > 0 ? std::max(0.0, r) / q.weight : 0.0;
+}
+
+struct PositionHash
+{
+	size_t operator()(const glm::vec3 &p) const
+	{
+		unsigned int x, y, z;
+		memcpy(&x, &p.x, 4); memcpy(&y, &p.y, 4); memcpy(&z, &p.z, 4);
+		return (x * 73856093u) ^ (y * 19349663u) ^ (z * 83492791u);
+	}
+};
+
+struct PositionEqual
+{
+	bool operator()(const glm::vec3 &a, const glm::vec3 &b) const
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+};
+
+struct Collapse
+{
+	int from, to;
+	double cost;
+
+	bool operator<(const Collapse &other) const
+	{
+		return cost < other.cost;
+	}
+};
+
+//finds the vertices that must stay in place: the ones sharing a position with another vertex
+//(uv or normal seams) and the ones on edges used by a single triangle (open borders)
+static std::vector<bool> findLockedVertices(const std::vector<Vertex> &vertices, const std::vector<int> &indices)
+{
+	std::vector<bool> locked(vertices.size(), false);
+
+	std::unordered_map<glm::vec3, int, PositionHash, PositionEqual> firstWithPosition;
+	std::vector<int> position(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		auto inserted = firstWithPosition.emplace(vertices[i].pos, (int)i);
+		position[i] = inserted.first->second;
+		if (!inserted.second)
+		{
+			locked[i] = true;
+			locked[inserted.first->second] = true;
+		}
+	}
+
+	std::unordered_map<unsigned long long, int> edgeUses;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (int e = 0; e < 3; e++)
+		{
+			unsigned int a = position[indices[i + e]];
+			unsigned int b = position[indices[i + (e + 1) % 3]];
+			unsigned long long key = a < b ? ((unsigned long long)a << 32 | b) : ((unsigned long long)b << 32 | a);
+			edgeUses[key]++;
+		}
+	}
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		for (int e = 0; e < 3; e++)
+		{
+			int a = indices[i + e];
+			int b = indices[i + (e + 1) % 3];
+			unsigned int pa = position[a], pb = position[b];
+			unsigned long long key = pa < pb ? ((unsigned long long)pa << 32 | pb) : ((unsigned long long)pb << 32 | pa);
+			if (edgeUses[key] == 1)
+				locked[a] = locked[b] = true;
+		}
+	}
+
+	return locked;
+}
+
+//moving from onto to must not turn any remaining triangle around from upside down
+static bool collapseFlips(const std::vector<Vertex> &vertices, const std::vector<int> &triangles,
+	const std::vector<int> &adjacencyOffset, const std::vector<int> &adjacency, int from, int to)
+{
+	const glm::vec3 &target = vertices[to].pos;
+
+	for (int k = adjacencyOffset[from]; k < adjacencyOffset[from + 1]; k++)
+	{
+		const int *t = &triangles[adjacency[k] * 3];
+		if (t[0] == to || t[1] == to || t[2] == to)
+			continue; //this triangle collapses away
+
+		glm::vec3 p[3], q[3];
+		for (int c = 0; c < 3; c++)
+		{
+			p[c] = vertices[t[c]].pos;
+			q[c] = t[c] == from ? target : p[c];
+		}
+
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+		if (glm::dot(before, after) <= 0.0f)
+			return true;
+	}
+
+	return false;
+}
+
+std::vector<int> simplifyMesh(const std::vector<Vertex> &vertices, const std::vector<int> &indices, size_t targetIndexCount, float maxError, float &error)
+{
+	std::vector<int> triangles(indices);
+	error = 0.0f;
+
+	std::vector<bool> locked = findLockedVertices(vertices, indices);
+
+	std::vector<Quadric> quadrics(vertices.size(), Quadric());
+	for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+	{
+		const glm::vec3 &p0 = vertices[triangles[i]].pos;
+		const glm::vec3 &p1 = vertices[triangles[i + 1]].pos;
+		const glm::vec3 &p2 = vertices[triangles[i + 2]].pos;
+
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(normal);
+		if (area == 0.0f)
+			continue;
+
+		normal /= area;
+		float d = -glm::dot(normal, p0);
+		for (int c = 0; c < 3; c++)
+			addPlane(quadrics[triangles[i + c]], normal, d, area * 0.5);
+	}
+
+	double maxCost = (double)maxError * maxError;
+	std::vector<int> remap(vertices.size());
+	std::vector<bool> touched(vertices.size());
+	std::vector<int> adjacencyOffset(vertices.size() + 1);
+	std::vector<int> adjacency;
+	std::vector<Collapse> collapses;
+
+	//each pass collapses the cheapest edges that do not share a neighbourhood, then rebuilds the triangles
+	while (triangles.size() > targetIndexCount)
+	{
+		size_t triangleCount = triangles.size() / 3;
+
+		//vertex -> triangles adjacency, in CSR form
+		std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+		for (size_t i = 0; i < triangles.size(); i++)
+			adjacencyOffset[triangles[i] + 1]++;
+		for (size_t i = 1; i < adjacencyOffset.size(); i++)
+			adjacencyOffset[i] += adjacencyOffset[i - 1];
+
+		adjacency.resize(triangles.size());
+		std::vector<int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (size_t i = 0; i < triangles.size(); i++)
+			adjacency[fill[triangles[i]]++] = (int)(i / 3);
+
+		//every edge can collapse either way, as long as the vertex that moves is free to
+		collapses.clear();
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				int a = triangles[i + e];
+				int b = triangles[i + (e + 1) % 3];
+
+				for (int direction = 0; direction < 2; direction++)
+				{
+					int from = direction == 0 ? a : b;
+					int to = direction == 0 ? b : a;
+					if (locked[from])
+						continue;
+
+					Quadric q = quadrics[from];
+					addQuadric(q, quadrics[to]);
+
+					Collapse collapse = { from, to, quadricError(q, vertices[to].pos) };
+					if (collapse.cost <= maxCost)
+						collapses.push_back(collapse);
+				}
+			}
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end());
+
+		for (size_t i = 0; i < remap.size(); i++)
+			remap[i] = (int)i;
+		std::fill(touched.begin(), touched.end(), false);
+
+		//every collapse removes about two triangles
+		size_t wanted = (triangles.size() - targetIndexCount) / 6 + 1;
+		size_t applied = 0;
+
+		for (size_t i = 0; i < collapses.size() && applied < wanted; i++)
+		{
+			const Collapse &collapse = collapses[i];
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+			if (collapseFlips(vertices, triangles, adjacencyOffset, adjacency, collapse.from, collapse.to))
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			addQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			error = std::max(error, (float)std::sqrt(collapse.cost));
+
+			//the triangles around from change shape, keep their vertices still for the rest of the pass
+			for (int k = adjacencyOffset[collapse.from]; k < adjacencyOffset[collapse.from + 1]; k++)
+			{
+				const int *t = &triangles[adjacency[k] * 3];
+				touched[t[0]] = touched[t[1]] = touched[t[2]] = true;
+			}
+			applied++;
+		}
+
+		if (applied == 0)
+			break;
+
+		//drop the triangles that collapsed to a line
+		size_t write = 0;
+		for (size_t i = 0; i < triangleCount; i++)
+		{
+			int a = remap[triangles[i * 3]];
+			int b = remap[triangles[i * 3 + 1]];
+			int c = remap[triangles[i * 3 + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			triangles[write++] = a;
+			triangles[write++] = b;
+			triangles[write++] = c;
+		}
+		triangles.resize(write);
+	}
+
+	return triangles;
+}
+
+void buildLodChain(const std::vector<Vertex> &vertices, std::vector<int> &indices, std::vector<MeshLod> &lods, unsigned int levels)
+{
+	lods.clear();
+	if (indices.empty())
+		return;
+
+	MeshLod base = { 0, (unsigned int)indices.size(), 0.0f };
+	lods.push_back(base);
+
+	//never let a level drift from the original surface by more than a few percent of the mesh size
+	glm::vec3 boundsMin, boundsMax;
+	computeBounds(vertices.data(), vertices.size(), boundsMin, boundsMax);
+	float maxError = glm::length(boundsMax - boundsMin) * 0.05f;
+
+	std::vector<int> previous(indices.begin(), indices.end());
+
+	for (unsigned int level = 1; level < levels; level++)
+	{
+		size_t target = (previous.size() / 2) / 3 * 3;
+		if (target < 36)
+			break;
+
+		float error;
+		std::vector<int> simplified = simplifyMesh(vertices, previous, target, maxError, error);
+
+		//stop once simplification no longer pays for another level
+		if (simplified.empty() || simplified.size() > previous.size() * 85 / 100)
+			break;
+
+		MeshLod lod = { (unsigned int)indices.size(), (unsigned int)simplified.size(), std::max(error, lods.back().error) };
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		lods.push_back(lod);
+
+		previous.swap(simplified);
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+
+//simplifies a triangle list by collapsing edges in order of their quadric error (Garland & Heckbert)
+//the result indexes the same vertex array, vertices on open borders or uv/normal seams never move
+//stops at targetIndexCount or when the next collapse would move the surface by more than maxError
+//returns the new index list, error receives the largest deviation introduced
+std::vector<int> simplifyMesh(const std::vector<Vertex> &vertices, const std::vector<int> &indices, size_t targetIndexCount, float maxError, float &error);
+
+//appends up to levels - 1 simplified copies of the first lod to indices (each about half the previous one)
+//and describes every level in lods, level 0 being the original triangles
+void buildLodChain(const std::vector<Vertex> &vertices, std::vector<int> &indices, std::vector<MeshLod> &lods, unsigned int levels);
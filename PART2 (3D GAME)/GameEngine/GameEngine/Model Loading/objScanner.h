@@ -0,0 +1,90 @@
+#pragma once
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+//helper functions for scanning obj text in place, without copying lines or allocating tokens
+
+inline bool _isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+//returns the line starting at cursor (without the '\n') and moves cursor to the next line
+inline std::string_view _nextLine(const char *&cursor, const char *end)
+{
+	const char *lineEnd = (const char*)memchr(cursor, '\n', end - cursor);
+	if (lineEnd == nullptr)
+		lineEnd = end;
+
+	std::string_view line(cursor, lineEnd - cursor);
+	cursor = lineEnd < end ? lineEnd + 1 : end;
+	return line;
+}
+
+//returns the next whitespace separated token of [cursor, end) and moves cursor past it
+//an empty token means the end of the range was reached
+inline std::string_view _nextToken(const char *&cursor, const char *end)
+{
+	while (cursor < end && _isBlank(*cursor))
+		cursor++;
+
+	const char *start = cursor;
+	while (cursor < end && !_isBlank(*cursor))
+		cursor++;
+
+	return std::string_view(start, cursor - start);
+}
+
+//parses the longest numeric prefix of the token, 0 if there is none (same as reading it from a stream)
+inline float _parseFloat(std::string_view token)
+{
+	const char *first = token.data();
+	const char *last = first + token.size();
+	if (first < last && *first == '+')
+		first++;
+
+	float result = 0.0f;
+	std::from_chars(first, last, result);
+	return result;
+}
+
+inline int _parseInt(std::string_view token)
+{
+	const char *first = token.data();
+	const char *last = first + token.size();
+	if (first < last && *first == '+')
+		first++;
+
+	int result = 0;
+	std::from_chars(first, last, result);
+	return result;
+}
+
+//splits a face corner such as "1/2/3", "1//3" or "1/2" on '/' and '\', skipping empty parts
+//returns how many parts the corner has, only the first 3 are parsed into values
+inline int _parseFaceCorner(std::string_view token, int values[3])
+{
+	int count = 0;
+	size_t i = 0;
+
+	values[0] = values[1] = values[2] = 0;
+	while (i < token.size())
+	{
+		if (token[i] == '/' || token[i] == '\\')
+		{
+			i++;
+			continue;
+		}
+
+		size_t start = i;
+		while (i < token.size() && token[i] != '/' && token[i] != '\\')
+			i++;
+
+		if (count < 3)
+			values[count] = _parseInt(token.substr(start, i - start));
+		count++;
+	}
+
+	return count;
+}
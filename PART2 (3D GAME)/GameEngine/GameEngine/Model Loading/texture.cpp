@@ -1,101 +1,598 @@
 #include "texture.h"
 #include <iostream>
 #include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-GLuint loadBMP(const char * imagepath) {
+bool decodeImage(const char * imagepath, TextureData &image, bool flipVertically, UploadRing *ring) {
+	int width, height, nrChannels;
 
-	printf("Reading image %s\n", imagepath);
+	unsigned char* data = stbi_load(imagepath, &width, &height, &nrChannels, 0);
+	if (!data)
+		return false;
 
-	unsigned char header[54];
-	unsigned int dataPos;
-	unsigned int imageSize;
-	unsigned int width, height;
+	//one byte per channel, the internal format follows the file instead of always being RGB
+	static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
 
-	unsigned char * data;
+	image.width = width;
+	image.height = height;
+	image.channels = nrChannels;
+	image.format = formats[nrChannels - 1];
+	image.internalFormat = internalFormats[nrChannels - 1];
 
-	FILE * file;
-	errno_t err = fopen_s(&file, imagepath, "rb");
-	if (err)
-	{
-		printf("%s could not be opened.", imagepath); getchar(); return 0;
+	//the rows are flipped on their way into the ring, no extra copy in between
+	size_t size = (size_t)width * height * nrChannels;
+	unsigned char *destination;
+	if (ring && ring->allocate(size, image.staging))
+		destination = image.staging.data;
+	else {
+		image.pixels.resize(size);
+		destination = image.pixels.data();
 	}
 
-	if (fread(header, 1, 54, file) != 54) {
-		printf("Not a correct BMP file\n");
-		return 0;
+	size_t rowSize = (size_t)width * nrChannels;
+	for (int row = 0; row < height; row++) {
+		int source = flipVertically ? height - 1 - row : row;
+		memcpy(destination + row * rowSize, data + source * rowSize, rowSize);
 	}
+	stbi_image_free(data);
 
-	// Parsing BMP file
-	if (header[0] != 'B' || header[1] != 'M') {
-		printf("Not a correct BMP file\n");
-		return 0;
+	return true;
+}
+
+//little endian, like both containers
+static uint32_t read32(const unsigned char *bytes) {
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint64_t read64(const unsigned char *bytes) {
+	return read32(bytes) | ((uint64_t)read32(bytes + 4) << 32);
+}
+
+//bytes of one level: BC1 packs a 4x4 block in 8 bytes, BC3 and BC7 in 16, plain levels are tightly packed rows
+static size_t levelSize(const TextureData &face, int width, int height) {
+	if (!face.compressed)
+		return (size_t)width * height * face.channels;
+
+	GLenum internalFormat = face.internalFormat;
+	size_t blockBytes = internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+		internalFormat == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT ? 8 : 16;
+	return std::max<size_t>(1, ((size_t)width + 3) / 4) * std::max<size_t>(1, ((size_t)height + 3) / 4) * blockBytes;
+}
+
+//levels from the full size down to 1x1; a file claiming more than this is damaged
+static int mipChainLength(int width, int height) {
+	int levels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+		levels++;
+	return levels;
+}
+
+//levels point into the mapped file, nothing is copied
+static void addLevel(TextureData &face, int width, int height, size_t offset, size_t size) {
+	TextureLevel level = { width, height, offset, size };
+	face.levels.push_back(level);
+}
+
+static void startFaces(std::vector<TextureData> &faces, int faceCount, const TextureData &format, int width, int height) {
+	faces.assign(faceCount, format);
+	for (int i = 0; i < faceCount; i++) {
+		faces[i].width = width;
+		faces[i].height = height;
+	}
+}
+
+static TextureData compressedFormat(GLenum internalFormat) {
+	TextureData format;
+	format.format = internalFormat;
+	format.internalFormat = internalFormat;
+	format.channels = 4;
+	format.compressed = internalFormat != 0;
+	return format;
+}
+
+static TextureData ddsFormat(uint32_t fourCC, uint32_t dxgiFormat) {
+	if (fourCC == 0x31545844)       //DXT1
+		return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+	if (fourCC == 0x35545844)       //DXT5
+		return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+
+	switch (dxgiFormat) {
+	case 71: return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+	case 72: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT);
+	case 77: return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	case 78: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT);
+	case 98: return compressedFormat(GL_COMPRESSED_RGBA_BPTC_UNORM);
+	case 99: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM);
+	default: return compressedFormat(0);
 	}
+}
 
-	if (*(int*)&(header[0x1E]) != 0) { printf("Not a correct BMP file\n");    return 0; }
-	if (*(int*)&(header[0x1C]) != 24) { printf("Not a correct BMP file\n");    return 0; }
+//faces one after the other, each with its whole mip chain
+static bool decodeDDS(const unsigned char *file, size_t fileSize, std::vector<TextureData> &faces) {
+	if (fileSize < 128 || memcmp(file, "DDS ", 4) != 0)
+		return false;
 
-	dataPos = *(int*)&(header[0x0A]);
-	imageSize = *(int*)&(header[0x22]);
-	width = *(int*)&(header[0x12]);
-	height = *(int*)&(header[0x16]);
+	const unsigned char *header = file + 4;
+	uint32_t flags = read32(header + 4);
+	int height = read32(header + 8);
+	int width = read32(header + 12);
+	int levelCount = (flags & 0x20000) ? std::max(1, (int)read32(header + 24)) : 1;
+	uint32_t fourCC = read32(header + 80);
+	uint32_t caps2 = read32(header + 108);
 
-	if (imageSize == 0)    imageSize = width*height * 3; 
-	if (dataPos == 0)      dataPos = 54; 
+	//a cubemap has to have all six faces
+	int faceCount = (caps2 & 0x200) ? 6 : 1;
+	if (faceCount == 6 && (caps2 & 0xFC00) != 0xFC00)
+		return false;
 
-										
-	data = new unsigned char[imageSize];
+	size_t offset = 128;
+	uint32_t dxgiFormat = 0;
+	if (fourCC == 0x30315844) {     //DX10, followed by a second header
+		if (fileSize < 148)
+			return false;
+		dxgiFormat = read32(file + 128);
+		if (read32(file + 136) & 0x4)
+			faceCount = 6;
+		offset = 148;
+	}
 
-	// Read data into buffer
-	fread(data, 1, imageSize, file);
+	TextureData format = ddsFormat(fourCC, dxgiFormat);
+	if (!format.compressed || width <= 0 || height <= 0 || levelCount > mipChainLength(width, height))
+		return false;
 
-	fclose(file);
+	startFaces(faces, faceCount, format, width, height);
+	for (int face = 0; face < faceCount; face++) {
+		int levelWidth = width, levelHeight = height;
+		for (int level = 0; level < levelCount; level++) {
+			size_t size = levelSize(format, levelWidth, levelHeight);
+			if (offset + size > fileSize)
+				return false;
 
-	// Create OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
+			addLevel(faces[face], levelWidth, levelHeight, offset, size);
+			offset += size;
+			levelWidth = std::max(1, levelWidth / 2);
+			levelHeight = std::max(1, levelHeight / 2);
+		}
+	}
+
+	return true;
+}
+
+//block compressed formats and the plain 8 bit ones assetbake writes when not compressing
+static TextureData ktx2Format(uint32_t vkFormat) {
+	static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+
+	int channels = 0;
+	switch (vkFormat) {
+	case 131: return compressedFormat(GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+	case 132: return compressedFormat(GL_COMPRESSED_SRGB_S3TC_DXT1_EXT);
+	case 133: return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+	case 134: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT);
+	case 137: return compressedFormat(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+	case 138: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT);
+	case 145: return compressedFormat(GL_COMPRESSED_RGBA_BPTC_UNORM);
+	case 146: return compressedFormat(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM);
+	case 9: channels = 1; break;
+	case 16: channels = 2; break;
+	case 23: channels = 3; break;
+	case 37: channels = 4; break;
+	default: return compressedFormat(0);
+	}
+
+	TextureData format;
+	format.channels = channels;
+	format.format = formats[channels - 1];
+	format.internalFormat = internalFormats[channels - 1];
+	return format;
+}
+
+//a level index gives where every level starts, the faces of a level follow each other
+static bool decodeKTX2(const unsigned char *file, size_t fileSize, std::vector<TextureData> &faces) {
+	static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	if (fileSize < 80 || memcmp(file, identifier, 12) != 0)
+		return false;
+
+	TextureData format = ktx2Format(read32(file + 12));
+	int width = read32(file + 20);
+	int height = read32(file + 24);
+	uint32_t depth = read32(file + 28);
+	uint32_t layerCount = read32(file + 32);
+	int faceCount = read32(file + 36);
+	int levelCount = std::max(1, (int)read32(file + 40));
+	uint32_t supercompression = read32(file + 44);
+
+	//plain 2D images and cubemaps only, not arrays, volumes or Basis/zstd supercompressed data
+	if (format.internalFormat == 0 || width <= 0 || height <= 0 || depth != 0 || layerCount > 1 || supercompression != 0 ||
+		(faceCount != 1 && faceCount != 6) || levelCount > mipChainLength(width, height) || fileSize < 80 + (size_t)levelCount * 24)
+		return false;
+
+	startFaces(faces, faceCount, format, width, height);
+	for (int level = 0; level < levelCount; level++) {
+		uint64_t offset = read64(file + 80 + level * 24);
+		uint64_t length = read64(file + 80 + level * 24 + 8);
+		int levelWidth = std::max(1, width >> level);
+		int levelHeight = std::max(1, height >> level);
+		size_t size = levelSize(format, levelWidth, levelHeight);
+		//the offset comes from the file, offset + length could wrap around
+		if (length < size * faceCount || offset > fileSize || length > fileSize - offset)
+			return false;
+
+		for (int face = 0; face < faceCount; face++)
+			addLevel(faces[face], levelWidth, levelHeight, offset + face * size, size);
+	}
+
+	return true;
+}
+
+bool decodeContainer(const char * path, std::vector<TextureData> &faces) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(path))
+		return false;
+
+	const unsigned char *bytes = (const unsigned char*)file->data();
+	if (!decodeKTX2(bytes, file->size(), faces) && !decodeDDS(bytes, file->size(), faces)) {
+		faces.clear();
+		return false;
+	}
+
+	for (unsigned int i = 0; i < faces.size(); i++)
+		faces[i].file = file;
+	return true;
+}
+
+//moves the levels (or pixels) of a decoded image into the ring, one after the other; the image keeps
+//what it has when the ring is full
+static void stageTexture(TextureData &image, UploadRing *ring) {
+	if (!ring || image.staging.ring)
+		return;
+
+	size_t size = 0;
+	for (unsigned int i = 0; i < image.levels.size(); i++)
+		size += image.levels[i].size;
+	if (image.levels.empty())
+		size = image.pixels.size();
+	if (size == 0 || !ring->allocate(size, image.staging))
+		return;
+
+	if (image.levels.empty())
+		memcpy(image.staging.data, image.pixels.data(), size);
+
+	size_t offset = 0;
+	const unsigned char *source = image.file ? (const unsigned char*)image.file->data() : image.pixels.data();
+	for (unsigned int i = 0; i < image.levels.size(); i++) {
+		memcpy(image.staging.data + offset, source + image.levels[i].offset, image.levels[i].size);
+		image.levels[i].offset = offset;
+		offset += image.levels[i].size;
+	}
+
+	image.pixels.clear();
+	image.pixels.shrink_to_fit();
+	image.file.reset();
+}
+
+//whether the GL can take the decoded container as it is
+static bool isUsable(const std::vector<TextureData> &faces, unsigned int faceCount) {
+	return faces.size() == faceCount && (!faces[0].compressed || isCompressedFormatSupported(faces[0].internalFormat));
+}
+
+bool isCompressedFormatSupported(GLenum internalFormat) {
+	switch (internalFormat) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		return GLEW_EXT_texture_compression_s3tc;
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return GLEW_EXT_texture_compression_s3tc && GLEW_EXT_texture_sRGB;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+	default:
+		return false;
+	}
+}
+
+bool decodeTexture(const char * imagepath, TextureData &image, bool flipVertically, UploadRing *ring) {
+	std::string path = imagepath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? path.substr(0, dot) : path;
+
+	const char *extensions[2] = { ".ktx2", ".dds" };
+	for (int i = 0; i < 2; i++) {
+		std::vector<TextureData> faces;
+		std::string compressedPath = stem + extensions[i];
+		if (decodeContainer(compressedPath.c_str(), faces) && isUsable(faces, 1)) {
+			image = std::move(faces[0]);
+			stageTexture(image, ring);
+			return true;
+		}
+	}
+
+	return decodeImage(imagepath, image, flipVertically, ring);
+}
+
+//images that end up in one texture object: cubemap faces or array layers
+static bool decodeFaces(const std::vector<std::string> &paths, std::vector<TextureData> &faces, bool flipVertically, UploadRing *ring, const char *what) {
+	faces.assign(paths.size(), TextureData());
+	for (unsigned int i = 0; i < paths.size(); i++)
+		decodeTexture(paths[i].c_str(), faces[i], flipVertically);
+
+	//the faces have to agree on format and mip count, otherwise all of them go back to the plain images
+	bool mixed = false;
+	for (unsigned int i = 1; i < faces.size(); i++)
+		mixed = mixed || faces[i].compressed != faces[0].compressed || faces[i].internalFormat != faces[0].internalFormat ||
+			faces[i].levels.size() != faces[0].levels.size();
+
+	bool loaded = true;
+	int reference = -1;
+	for (unsigned int i = 0; i < paths.size(); i++) {
+		if (mixed) {
+			faces[i] = TextureData();
+			decodeImage(paths[i].c_str(), faces[i], flipVertically);
+		}
+		if (!faces[i].isEmpty() && reference >= 0 && (faces[i].width != faces[reference].width || faces[i].height != faces[reference].height)) {
+			std::cout << what << " does not match the size of " << paths[reference] << ": " << paths[i] << std::endl;
+			faces[i] = TextureData();
+			loaded = false;
+		}
+		else if (faces[i].isEmpty()) {
+			std::cout << what << " failed to load at path: " << paths[i] << std::endl;
+			loaded = false;
+		}
+		else if (reference < 0)
+			reference = i;
+	}
+
+	//staged only once the faces are settled, a face going back to its plain image would leave a region behind
+	for (unsigned int i = 0; i < faces.size(); i++)
+		stageTexture(faces[i], ring);
+
+	return loaded;
+}
+
+bool decodeCubemap(const std::vector<std::string> &paths, std::vector<TextureData> &faces, UploadRing *ring) {
+	if (paths.size() == 1) {
+		if (decodeContainer(paths[0].c_str(), faces) && isUsable(faces, 6)) {
+			for (unsigned int i = 0; i < faces.size(); i++)
+				stageTexture(faces[i], ring);
+			return true;
+		}
 
+		std::cout << "Cubemap texture failed to load at path: " << paths[0] << std::endl;
+		faces.clear();
+		return false;
+	}
+
+	return decodeFaces(paths, faces, false, ring, "Cubemap texture");
+}
+
+bool decodeTextureArray(const std::vector<std::string> &paths, std::vector<TextureData> &layers, UploadRing *ring) {
+	return decodeFaces(paths, layers, true, ring, "Texture array layer");
+}
+
+size_t textureSize(const TextureData &image) {
+	if (!image.levels.empty()) {
+		size_t size = 0;
+		for (unsigned int i = 0; i < image.levels.size(); i++)
+			size += image.levels[i].size;
+		return size;
+	}
+
+	//a full mip chain adds a third
+	return (size_t)image.width * image.height * image.channels * 4 / 3;
+}
+
+size_t cubemapSize(const std::vector<TextureData> &faces) {
+	size_t size = 0;
+	for (unsigned int i = 0; i < faces.size(); i++)
+		size += faces[i].levels.empty() ? (size_t)faces[i].width * faces[i].height * faces[i].channels : textureSize(faces[i]);
+	return size;
+}
+
+size_t textureArraySize(const std::vector<TextureData> &layers) {
+	size_t size = 0;
+	for (unsigned int i = 0; i < layers.size(); i++)
+		size += textureSize(layers[i].isEmpty() ? layers[0] : layers[i]);
+	return size;
+}
+
+//where the GL reads the image from: client memory, or an offset into the bound unpack buffer for staged images
+static const unsigned char *bindSource(const TextureData &image) {
+	if (image.staging.ring)
+		return (const unsigned char*)image.staging.ring->bind(image.staging);
+	return image.getPixels();
+}
+
+static void releaseSource(const TextureData &image) {
+	if (image.staging.ring)
+		image.staging.ring->release(image.staging);
+}
+
+//every level of an image decoded from a container, returns how many there are
+static int uploadLevels(GLenum target, const TextureData &image) {
+	const unsigned char *source = bindSource(image);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (unsigned int level = 0; level < image.levels.size(); level++) {
+		const TextureLevel &l = image.levels[level];
+		if (image.compressed)
+			glCompressedTexImage2D(target, level, image.internalFormat, l.width, l.height, 0, (GLsizei)l.size, source + l.offset);
+		else
+			glTexImage2D(target, level, image.internalFormat, l.width, l.height, 0, image.format, GL_UNSIGNED_BYTE, source + l.offset);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	releaseSource(image);
+	return image.levels.size();
+}
+
+//a plain image without a mip chain
+static void uploadImage(GLenum target, const TextureData &image) {
+	const unsigned char *source = bindSource(image);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(target, 0, image.internalFormat, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE, source);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	releaseSource(image);
+}
+
+//grey and grey + alpha images sample as grey instead of red
+static void setSwizzle(GLenum target, const TextureData &image) {
+	if (!image.compressed && (image.channels == 1 || image.channels == 2)) {
+		GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, image.channels == 2 ? GL_GREEN : GL_ONE };
+		glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+	}
+}
+
+void uploadTexture(GLuint textureID, const TextureData &image) {
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+	//a container brings its mip chain, a single level samples without mipmaps
+	int levels = 0;
+	if (!image.levels.empty()) {
+		levels = uploadLevels(GL_TEXTURE_2D, image);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+	else {
+		//rows of 1, 2 and 3 channel images are not padded to 4 bytes
+		uploadImage(GL_TEXTURE_2D, image);
+	}
 
-	delete[] data;
+	setSwizzle(GL_TEXTURE_2D, image);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	// Return the ID of the texture
-	return textureID;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels == 1 ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR);
+	if (levels == 0)
+		glGenerateMipmap(GL_TEXTURE_2D);
 }
 
-GLuint loadCubemap(const std::vector<std::string>& faces) {
-	GLuint textureID;
-	glGenTextures(1, &textureID);
+void uploadCubemap(GLuint textureID, const std::vector<TextureData> &faces) {
 	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-	int width, height, nrChannels;
-
+	int levels = 1;
 	for (unsigned int i = 0; i < faces.size(); i++) {
-		unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 3);
-		if (data) {
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-			stbi_image_free(data);
-		}
-		else {
-			std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
-			stbi_image_free(data);
-		}
+		if (!faces[i].levels.empty())
+			levels = uploadLevels(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, faces[i]);
+		else if (!faces[i].isEmpty())
+			uploadImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, faces[i]);
 	}
 
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
 
+//every level of one image into one layer of the bound array, the storage is already allocated
+static void uploadLayer(const TextureData &image, const unsigned char *source, int layer) {
+	if (image.levels.empty()) {
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.width, image.height, 1, image.format, GL_UNSIGNED_BYTE, source);
+		return;
+	}
+
+	for (unsigned int level = 0; level < image.levels.size(); level++) {
+		const TextureLevel &l = image.levels[level];
+		if (image.compressed)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, l.width, l.height, 1, image.internalFormat, (GLsizei)l.size, source + l.offset);
+		else
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, l.width, l.height, 1, image.format, GL_UNSIGNED_BYTE, source + l.offset);
+	}
+}
+
+void uploadTextureArray(GLuint textureID, const std::vector<TextureData> &layers) {
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+
+	//the layers agree on size and format (see decodeFaces), the first one that loaded stands for all of them
+	int reference = -1;
+	for (unsigned int i = 0; i < layers.size() && reference < 0; i++)
+		if (!layers[i].isEmpty())
+			reference = i;
+	if (reference < 0)
+		return;
+
+	//storage for every layer and level first, then each image goes into its layer
+	const TextureData &image = layers[reference];
+	GLsizei layerCount = (GLsizei)layers.size();
+	int levels = image.levels.empty() ? 1 : (int)image.levels.size();
+	for (int level = 0; level < levels; level++) {
+		int width = image.levels.empty() ? image.width : image.levels[level].width;
+		int height = image.levels.empty() ? image.height : image.levels[level].height;
+		if (image.compressed)
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, image.internalFormat, width, height, layerCount, 0, (GLsizei)(image.levels[level].size * layerCount), NULL);
+		else
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, image.internalFormat, width, height, layerCount, 0, image.format, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	//layers that failed to load show the reference image rather than undefined texels
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (unsigned int i = 0; i < layers.size(); i++) {
+		if (layers[i].isEmpty())
+			continue;
+
+		const unsigned char *source = bindSource(layers[i]);
+		for (unsigned int layer = 0; layer < layers.size(); layer++)
+			if (layer == i || ((int)i == reference && layers[layer].isEmpty()))
+				uploadLayer(layers[i], source, layer);
+		releaseSource(layers[i]);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	setSwizzle(GL_TEXTURE_2D_ARRAY, image);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	if (image.levels.empty()) {
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels == 1 ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR);
+	}
+}
+
+GLuint loadTexture(const char * imagepath) {
+	TextureData image;
+	if (!decodeTexture(imagepath, image, true))
+		return 0;
+
+	// Create OpenGL texture
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	uploadTexture(textureID, image);
+
+	// Return the ID of the texture
 	return textureID;
-}
\ No newline at end of file
+}
+
+GLuint loadCubemap(const std::vector<std::string>& faces) {
+	std::vector<TextureData> images;
+	decodeCubemap(faces, images);
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	uploadCubemap(textureID, images);
+
+	return textureID;
+}
+
+GLuint loadTextureArray(const std::vector<std::string>& layers) {
+	std::vector<TextureData> images;
+	decodeTextureArray(layers, images);
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	uploadTextureArray(textureID, images);
+
+	return textureID;
+}
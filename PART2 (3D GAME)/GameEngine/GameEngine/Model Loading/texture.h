@@ -2,8 +2,87 @@
 #include <glew.h>
 #include <glfw3.h>
 #include <vector>
+#include <string>
 #include <iostream>
+#include <memory>
+#include "mappedFile.h"
+#include "..\Graphics\uploadRing.h"
 
-GLuint loadBMP(const char * imagepath);
-GLuint loadCubemap(const std::vector<std::string>& faces);
+//one mip level of an image decoded from a container, a range of TextureData::getPixels()
+struct TextureLevel
+{
+	int width;
+	int height;
+	size_t offset;
+	size_t size;
+};
+
+//pixels decoded on the CPU, ready to be handed to glTexImage2D
+struct TextureData
+{
+	int width = 0;
+	int height = 0;
+	GLenum format = GL_RGB;
+	GLenum internalFormat = GL_RGB8;
+	int channels = 3;
+	std::vector<unsigned char> pixels;
+
+	//images from a KTX2 or DDS container bring their whole mip chain and stay in the mapped file;
+	//block compressed ones go to glCompressedTexImage2D as they are
+	bool compressed = false;
+	std::vector<TextureLevel> levels;
+	std::shared_ptr<MappedFile> file;
+
+	//pixels (or levels) written into an upload ring instead, the upload copies them from there on the GPU
+	UploadRegion staging;
+
+	const unsigned char *getPixels() const
+	{
+		if (staging.ring)
+			return staging.data;
+		return file ? (const unsigned char*)file->data() : pixels.data();
+	}
+
+	bool isEmpty() const
+	{
+		return pixels.empty() && levels.empty() && !staging.ring;
+	}
+};
 
+//decoding only touches the CPU, so it can run on any thread; given a ring, the pixels go straight into it
+//when it has room and stay in client memory otherwise
+//PNG, JPG, TGA and BMP through stb_image, keeping the file's channel count; flipVertically puts the
+//bottom row first, which is what glTexImage2D and the models' texture coordinates expect
+bool decodeImage(const char * imagepath, TextureData &image, bool flipVertically = false, UploadRing *ring = nullptr);
+
+//a KTX2 or DDS container mapped into memory with its mip chain: one face for 2D textures, six for cubemaps;
+//BC1, BC3 and BC7 blocks, or plain 8 bit levels from KTX2; the levels are uploaded as they are stored,
+//so 2D textures have to be stored bottom row first
+bool decodeContainer(const char * path, std::vector<TextureData> &faces);
+//needs the GL context to have been created
+bool isCompressedFormatSupported(GLenum internalFormat);
+
+//the .ktx2 or .dds next to imagepath (as written by assetbake) when the driver can use it, otherwise the image itself
+bool decodeTexture(const char * imagepath, TextureData &image, bool flipVertically = false, UploadRing *ring = nullptr);
+//one image per face, or a single compressed container holding all six
+bool decodeCubemap(const std::vector<std::string> &paths, std::vector<TextureData> &faces, UploadRing *ring = nullptr);
+//one 2D texture per layer, decoded like decodeTexture; a layer whose size differs from the first one is left empty
+bool decodeTextureArray(const std::vector<std::string> &paths, std::vector<TextureData> &layers, UploadRing *ring = nullptr);
+
+//video memory the image takes once uploaded, mipmaps included
+size_t textureSize(const TextureData &image);
+//all six faces; faces decoded from images are uploaded without mipmaps
+size_t cubemapSize(const std::vector<TextureData> &faces);
+//all layers; empty ones are uploaded as a copy of the first
+size_t textureArraySize(const std::vector<TextureData> &layers);
+
+//uploads have to run on the thread that owns the GL context; staged images are copied from the ring's
+//buffer and their regions handed back to it
+void uploadTexture(GLuint textureID, const TextureData &image);
+void uploadCubemap(GLuint textureID, const std::vector<TextureData> &faces);
+//a GL_TEXTURE_2D_ARRAY with one layer per image; empty layers get a copy of the first one
+void uploadTextureArray(GLuint textureID, const std::vector<TextureData> &layers);
+
+GLuint loadTexture(const char * imagepath);
+GLuint loadCubemap(const std::vector<std::string>& faces);
+GLuint loadTextureArray(const std::vector<std::string>& layers);
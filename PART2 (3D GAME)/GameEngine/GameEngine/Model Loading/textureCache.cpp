@@ -0,0 +1,175 @@
+#include "textureCache.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <vector>
+
+TextureHandle::TextureHandle()
+{
+}
+
+bool TextureHandle::isValid() const
+{
+	return slot && slot->id != 0;
+}
+
+GLuint TextureHandle::getId() const
+{
+	return slot ? slot->id : 0;
+}
+
+TextureCache::TextureCache(size_t budgetBytes)
+{
+	budget = budgetBytes;
+	usage = 0;
+	useClock = 0;
+}
+
+TextureCache::~TextureCache()
+{
+	for (auto it = textures.begin(); it != textures.end(); ++it)
+		glDeleteTextures(1, &it->second->id);
+}
+
+std::string TextureCache::canonicalPath(const std::string &filename)
+{
+	//weakly_canonical also works for files that do not exist (yet), they just never match anything else
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::absolute(filename, error), error);
+	std::string key = error ? filename : path.generic_string();
+
+#ifdef _WIN32
+	std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+	return key;
+}
+
+TextureHandle TextureCache::load(const std::string &filename)
+{
+	TextureHandle texture;
+	if (find(filename, texture))
+		return texture;
+
+	TextureData image;
+	if (!decodeTexture(filename.c_str(), image, true))
+	{
+		std::cout << "Texture failed to load at path: " << filename << std::endl;
+		return texture;
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	uploadTexture(textureID, image);
+
+	texture = insert(filename, textureID);
+	setSize(texture, textureSize(image));
+	return texture;
+}
+
+std::string TextureCache::canonicalKey(const std::vector<std::string> &filenames, GLenum target)
+{
+	//'|' cannot appear in a Windows path
+	std::string key = std::to_string(target);
+	for (size_t i = 0; i < filenames.size(); i++)
+		key += "|" + canonicalPath(filenames[i]);
+	return key;
+}
+
+bool TextureCache::find(const std::string &filename, TextureHandle &texture)
+{
+	return findKey(canonicalPath(filename), texture);
+}
+
+TextureHandle TextureCache::insert(const std::string &filename, GLuint textureID)
+{
+	return insertKey(canonicalPath(filename), textureID);
+}
+
+bool TextureCache::find(const std::vector<std::string> &filenames, GLenum target, TextureHandle &texture)
+{
+	return findKey(canonicalKey(filenames, target), texture);
+}
+
+TextureHandle TextureCache::insert(const std::vector<std::string> &filenames, GLenum target, GLuint textureID)
+{
+	return insertKey(canonicalKey(filenames, target), textureID);
+}
+
+bool TextureCache::findKey(const std::string &key, TextureHandle &texture)
+{
+	auto found = textures.find(key);
+	if (found == textures.end())
+		return false;
+
+	found->second->lastUsed = ++useClock;
+	texture.slot = found->second;
+	return true;
+}
+
+TextureHandle TextureCache::insertKey(const std::string &key, GLuint textureID)
+{
+	TextureHandle texture;
+	texture.slot = std::make_shared<TextureHandle::Slot>();
+	texture.slot->id = textureID;
+	texture.slot->path = key;
+	texture.slot->bytes = 0;
+	texture.slot->lastUsed = ++useClock;
+
+	textures[key] = texture.slot;
+	return texture;
+}
+
+void TextureCache::setSize(const TextureHandle &texture, size_t bytes)
+{
+	if (!texture.slot)
+		return;
+
+	usage -= texture.slot->bytes;
+	texture.slot->bytes = bytes;
+	usage += bytes;
+
+	if (usage > budget)
+		evict();
+}
+
+void TextureCache::setBudget(size_t budgetBytes)
+{
+	budget = budgetBytes;
+	if (usage > budget)
+		evict();
+}
+
+size_t TextureCache::getBudget()
+{
+	return budget;
+}
+
+size_t TextureCache::getUsage()
+{
+	return usage;
+}
+
+size_t TextureCache::size()
+{
+	return textures.size();
+}
+
+void TextureCache::evict()
+{
+	//only the cache's own reference left means nothing draws with the texture
+	std::vector<std::shared_ptr<TextureHandle::Slot>> unused;
+	for (auto it = textures.begin(); it != textures.end(); ++it)
+		if (it->second.use_count() == 1)
+			unused.push_back(it->second);
+
+	std::sort(unused.begin(), unused.end(), [](const std::shared_ptr<TextureHandle::Slot> &a, const std::shared_ptr<TextureHandle::Slot> &b) {
+		return a->lastUsed < b->lastUsed;
+	});
+
+	for (size_t i = 0; i < unused.size() && usage > budget; i++)
+	{
+		usage -= unused[i]->bytes;
+		glDeleteTextures(1, &unused[i]->id);
+		textures.erase(unused[i]->path);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "texture.h"
+
+//a texture owned by a TextureCache; while any handle to it is alive the cache will not evict it
+class TextureHandle
+{
+	public:
+		TextureHandle();
+
+		bool isValid() const;
+		GLuint getId() const;
+
+	private:
+		struct Slot
+		{
+			GLuint id;
+			std::string path;
+			size_t bytes;
+			unsigned long long lastUsed;
+		};
+		std::shared_ptr<Slot> slot;
+
+		friend class TextureCache;
+};
+
+//one texture per file, however many times and under whatever spelling of its path it is loaded;
+//textures nobody holds a handle to stay cached until the video memory budget runs out, then the
+//least recently used ones are deleted first
+class TextureCache
+{
+	public:
+		TextureCache(size_t budgetBytes = 256 * 1024 * 1024);
+		~TextureCache();
+
+		//decodes and uploads on a miss, on the calling (GL) thread
+		TextureHandle load(const std::string &filename);
+
+		//the cached texture for the file, if there is one; counts as a use
+		bool find(const std::string &filename, TextureHandle &texture);
+		//caches a texture the caller created for a file find missed, it counts 0 bytes until setSize
+		TextureHandle insert(const std::string &filename, GLuint textureID);
+		//the same for a texture made of several files, a cubemap or an array, cached under all of their paths in order
+		bool find(const std::vector<std::string> &filenames, GLenum target, TextureHandle &texture);
+		TextureHandle insert(const std::vector<std::string> &filenames, GLenum target, GLuint textureID);
+		//the video memory the texture takes now, evicts if that goes over budget
+		void setSize(const TextureHandle &texture, size_t bytes);
+
+		void setBudget(size_t budgetBytes);
+		size_t getBudget();
+		size_t getUsage();
+		size_t size();
+
+		//deletes unreferenced textures, least recently used first, until the cache fits its budget
+		void evict();
+
+		//the key a file is cached under: absolute, normalized, case insensitive on Windows
+		static std::string canonicalPath(const std::string &filename);
+		//the key for several files: the target, so a cubemap and an array of the same images stay apart, then every canonical path
+		static std::string canonicalKey(const std::vector<std::string> &filenames, GLenum target);
+
+	private:
+		std::unordered_map<std::string, std::shared_ptr<TextureHandle::Slot>> textures;
+		size_t budget;
+		size_t usage;
+		unsigned long long useClock;
+
+		bool findKey(const std::string &key, TextureHandle &texture);
+		TextureHandle insertKey(const std::string &key, GLuint textureID);
+};
@@ -0,0 +1,113 @@
+#include "vertexFormat.h"
+#include "mesh.h"
+#include <cmath>
+
+unsigned int vertexStride(VertexFormat format)
+{
+	return format == VERTEX_FLOAT ? sizeof(Vertex) : sizeof(PackedVertex);
+}
+
+glm::vec2 encodeOctahedral(glm::vec3 normal)
+{
+	float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (length == 0.0f)
+		return glm::vec2(0.0f);
+
+	normal /= length;
+	glm::vec2 encoded(normal.x, normal.y);
+
+	//the lower half is folded over the diagonals onto the outer triangles
+	if (normal.z < 0.0f)
+	{
+		encoded.x = (1.0f - fabsf(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - fabsf(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return encoded;
+}
+
+static short quantizeSnorm16(float value)
+{
+	value = glm::clamp(value, -1.0f, 1.0f);
+	return (short)(value >= 0.0f ? value * 32767.0f + 0.5f : value * 32767.0f - 0.5f);
+}
+
+static unsigned short quantizeUnorm16(float value)
+{
+	return (unsigned short)(glm::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+void packVertices(const Vertex *vertices, unsigned int vertexCount, VertexFormat format, std::vector<PackedVertex> &packed, VertexQuantization &quantization)
+{
+	quantization.positionScale = glm::vec3(1.0f);
+	quantization.positionOffset = glm::vec3(0.0f);
+	quantization.textureScale = glm::vec2(1.0f);
+	quantization.textureOffset = glm::vec2(0.0f);
+
+	packed.clear();
+	if (format == VERTEX_FLOAT || vertexCount == 0)
+		return;
+
+	glm::vec3 boundsMin, boundsMax;
+	computeBounds(vertices, vertexCount, boundsMin, boundsMax);
+
+	glm::vec2 textureMin = vertices[0].textureCoords;
+	glm::vec2 textureMax = vertices[0].textureCoords;
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		textureMin = glm::min(textureMin, vertices[i].textureCoords);
+		textureMax = glm::max(textureMax, vertices[i].textureCoords);
+	}
+
+	//positions are mapped to [-1, 1] around the center of the bounds, flat axes keep a scale of 1
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+	for (int axis = 0; axis < 3; axis++)
+		if (extent[axis] <= 0.0f)
+			extent[axis] = 1.0f;
+
+	//texture coordinates may repeat outside [0, 1], so they are mapped from their own range
+	glm::vec2 textureRange = textureMax - textureMin;
+	for (int axis = 0; axis < 2; axis++)
+		if (textureRange[axis] <= 0.0f)
+			textureRange[axis] = 1.0f;
+
+	//snorm16 is read as an integer and scaled in the shader, the old (2c + 1) / 65535
+	//normalization of GL 3.3 would shift every position by half a step
+	quantization.positionScale = format == VERTEX_SNORM16 ? extent / 32767.0f : extent;
+	quantization.positionOffset = center;
+	quantization.textureScale = textureRange;
+	quantization.textureOffset = textureMin;
+
+	packed.resize(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		const Vertex &vertex = vertices[i];
+		PackedVertex &out = packed[i];
+
+		glm::vec3 pos = (vertex.pos - center) / extent;
+		if (format == VERTEX_HALF)
+		{
+			glm::uint xy = glm::packHalf2x16(glm::vec2(pos.x, pos.y));
+			glm::uint z = glm::packHalf2x16(glm::vec2(pos.z, 0.0f));
+			out.pos[0] = (unsigned short)(xy & 0xFFFF);
+			out.pos[1] = (unsigned short)(xy >> 16);
+			out.pos[2] = (unsigned short)(z & 0xFFFF);
+		}
+		else
+		{
+			out.pos[0] = (unsigned short)quantizeSnorm16(pos.x);
+			out.pos[1] = (unsigned short)quantizeSnorm16(pos.y);
+			out.pos[2] = (unsigned short)quantizeSnorm16(pos.z);
+		}
+		out.pos[3] = 0;
+
+		glm::vec2 normal = encodeOctahedral(vertex.normals);
+		out.normal[0] = quantizeSnorm16(normal.x);
+		out.normal[1] = quantizeSnorm16(normal.y);
+
+		glm::vec2 textureCoords = (vertex.textureCoords - textureMin) / textureRange;
+		out.textureCoords[0] = quantizeUnorm16(textureCoords.x);
+		out.textureCoords[1] = quantizeUnorm16(textureCoords.y);
+	}
+}
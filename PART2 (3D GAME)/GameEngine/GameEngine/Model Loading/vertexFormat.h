@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <glm.hpp>
+
+struct Vertex;
+
+//layout a mesh is uploaded in; the packed ones are 16 bytes per vertex instead of 32
+enum VertexFormat
+{
+	VERTEX_FLOAT,   //Vertex as it is in memory
+	VERTEX_HALF,    //half float positions, octahedral normals, unorm16 texture coordinates
+	VERTEX_SNORM16  //like VERTEX_HALF but with 16 bit signed integer positions
+};
+
+//positions are stored relative to the bounds, texture coordinates relative to their range;
+//the vertex shader gets back the original value with value * scale + offset
+struct VertexQuantization
+{
+	glm::vec3 positionScale, positionOffset;
+	glm::vec2 textureScale, textureOffset;
+};
+
+struct PackedVertex
+{
+	unsigned short pos[4];           //half floats or snorm16 depending on the format, the fourth is padding
+	short normal[2];                 //octahedral encoding, decoded in the vertex shader
+	unsigned short textureCoords[2];
+};
+
+//bytes per vertex in the given format
+unsigned int vertexStride(VertexFormat format);
+
+//unit vector folded onto the octahedron and flattened to [-1, 1]^2
+glm::vec2 encodeOctahedral(glm::vec3 normal);
+
+//fills packed (unless format is VERTEX_FLOAT) and the values the shader needs to undo the packing
+void packVertices(const Vertex *vertices, unsigned int vertexCount, VertexFormat format, std::vector<PackedVertex> &packed, VertexQuantization &quantization);
@@ -0,0 +1,362 @@
+#include "aabbTree.h"
+#include <algorithm>
+
+static float surfaceArea(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	glm::vec3 size = boundsMax - boundsMin;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+static bool overlaps(const glm::vec3 &minA, const glm::vec3 &maxA, const glm::vec3 &minB, const glm::vec3 &maxB)
+{
+	return minA.x <= maxB.x && maxA.x >= minB.x &&
+		minA.y <= maxB.y && maxA.y >= minB.y &&
+		minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+static bool contains(const glm::vec3 &outerMin, const glm::vec3 &outerMax, const glm::vec3 &innerMin, const glm::vec3 &innerMax)
+{
+	return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z &&
+		outerMax.x >= innerMax.x && outerMax.y >= innerMax.y && outerMax.z >= innerMax.z;
+}
+
+//slab test, enter is where the ray enters the box (0 when it starts inside)
+static bool rayHitsBox(const glm::vec3 &origin, const glm::vec3 &inverseDirection, float maxDistance,
+	const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float &enter)
+{
+	glm::vec3 t1 = (boundsMin - origin) * inverseDirection;
+	glm::vec3 t2 = (boundsMax - origin) * inverseDirection;
+	glm::vec3 entering = glm::min(t1, t2);
+	glm::vec3 leaving = glm::max(t1, t2);
+
+	enter = std::max(0.0f, std::max(entering.x, std::max(entering.y, entering.z)));
+	float exit = std::min(maxDistance, std::min(leaving.x, std::min(leaving.y, leaving.z)));
+	return enter <= exit;
+}
+
+AABBTree::AABBTree(float margin)
+{
+	this->margin = margin;
+	root = -1;
+	freeNodes = -1;
+}
+
+int AABBTree::allocateNode()
+{
+	if (freeNodes == -1)
+	{
+		nodes.push_back(Node());
+		freeNodes = nodes.size() - 1;
+		nodes[freeNodes].parent = -1;
+	}
+
+	int node = freeNodes;
+	freeNodes = nodes[node].parent;
+	nodes[node].parent = -1;
+	nodes[node].left = -1;
+	nodes[node].right = -1;
+	nodes[node].height = 0;
+	return node;
+}
+
+void AABBTree::freeNode(int node)
+{
+	nodes[node].parent = freeNodes;
+	nodes[node].height = -1;
+	freeNodes = node;
+}
+
+void AABBTree::insert(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	remove(id);
+
+	int leaf = allocateNode();
+	Node &node = nodes[leaf];
+	node.exactMin = boundsMin;
+	node.exactMax = boundsMax;
+	node.boundsMin = boundsMin - glm::vec3(margin);
+	node.boundsMax = boundsMax + glm::vec3(margin);
+	node.id = id;
+
+	insertLeaf(leaf);
+	leaves[id] = leaf;
+}
+
+void AABBTree::remove(unsigned int id)
+{
+	auto found = leaves.find(id);
+	if (found == leaves.end())
+		return;
+
+	removeLeaf(found->second);
+	freeNode(found->second);
+	leaves.erase(found);
+}
+
+void AABBTree::move(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	auto found = leaves.find(id);
+	if (found == leaves.end())
+	{
+		insert(id, boundsMin, boundsMax);
+		return;
+	}
+
+	int leaf = found->second;
+	nodes[leaf].exactMin = boundsMin;
+	nodes[leaf].exactMax = boundsMax;
+	if (contains(nodes[leaf].boundsMin, nodes[leaf].boundsMax, boundsMin, boundsMax))
+		return;
+
+	removeLeaf(leaf);
+	nodes[leaf].boundsMin = boundsMin - glm::vec3(margin);
+	nodes[leaf].boundsMax = boundsMax + glm::vec3(margin);
+	insertLeaf(leaf);
+}
+
+void AABBTree::clear()
+{
+	nodes.clear();
+	leaves.clear();
+	root = -1;
+	freeNodes = -1;
+}
+
+//box and height of an inner node from its children
+void AABBTree::refit(int node)
+{
+	Node &n = nodes[node];
+	n.boundsMin = glm::min(nodes[n.left].boundsMin, nodes[n.right].boundsMin);
+	n.boundsMax = glm::max(nodes[n.left].boundsMax, nodes[n.right].boundsMax);
+	n.height = 1 + std::max(nodes[n.left].height, nodes[n.right].height);
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+	if (root == -1)
+	{
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	//walk down to the sibling that makes the tree's total surface area grow the least
+	glm::vec3 leafMin = nodes[leaf].boundsMin;
+	glm::vec3 leafMax = nodes[leaf].boundsMax;
+	int index = root;
+	while (nodes[index].left != -1)
+	{
+		const Node &node = nodes[index];
+		float area = surfaceArea(node.boundsMin, node.boundsMax);
+		float combinedArea = surfaceArea(glm::min(node.boundsMin, leafMin), glm::max(node.boundsMax, leafMax));
+
+		//pairing with this node makes a new parent; going further down grows this node's box for everything below it
+		float cost = 2.0f * combinedArea;
+		float inheritedCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.left, node.right };
+		for (int c = 0; c < 2; c++)
+		{
+			const Node &child = nodes[children[c]];
+			float grown = surfaceArea(glm::min(child.boundsMin, leafMin), glm::max(child.boundsMax, leafMax));
+			if (child.left == -1)
+				childCost[c] = grown + inheritedCost;
+			else
+				childCost[c] = grown - surfaceArea(child.boundsMin, child.boundsMax) + inheritedCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].left = sibling;
+	nodes[newParent].right = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	refit(newParent);
+
+	if (oldParent == -1)
+		root = newParent;
+	else if (nodes[oldParent].left == sibling)
+		nodes[oldParent].left = newParent;
+	else
+		nodes[oldParent].right = newParent;
+
+	for (int node = nodes[leaf].parent; node != -1; node = nodes[node].parent)
+	{
+		node = balance(node);
+		refit(node);
+	}
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = -1;
+		return;
+	}
+
+	//the parent goes away and the sibling takes its place
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+	freeNode(parent);
+
+	if (grandParent == -1)
+	{
+		root = sibling;
+		nodes[sibling].parent = -1;
+		return;
+	}
+
+	if (nodes[grandParent].left == parent)
+		nodes[grandParent].left = sibling;
+	else
+		nodes[grandParent].right = sibling;
+	nodes[sibling].parent = grandParent;
+
+	for (int node = grandParent; node != -1; node = nodes[node].parent)
+	{
+		node = balance(node);
+		refit(node);
+	}
+}
+
+//when one child is more than one level taller than the other, the taller child moves up in node's place;
+//returns the node now at that place
+int AABBTree::balance(int a)
+{
+	if (nodes[a].left == -1 || nodes[a].height < 2)
+		return a;
+
+	int b = nodes[a].left;
+	int c = nodes[a].right;
+	int difference = nodes[c].height - nodes[b].height;
+	if (difference >= -1 && difference <= 1)
+		return a;
+
+	//up is the taller child, stay is the other one; up's taller child stays with it, its shorter one goes to a
+	int up = difference > 1 ? c : b;
+	int stay = difference > 1 ? b : c;
+	int f = nodes[up].left;
+	int g = nodes[up].right;
+	int kept = nodes[f].height > nodes[g].height ? f : g;
+	int given = kept == f ? g : f;
+
+	nodes[up].parent = nodes[a].parent;
+	if (nodes[up].parent == -1)
+		root = up;
+	else if (nodes[nodes[up].parent].left == a)
+		nodes[nodes[up].parent].left = up;
+	else
+		nodes[nodes[up].parent].right = up;
+
+	nodes[up].left = a;
+	nodes[up].right = kept;
+	nodes[a].parent = up;
+
+	nodes[a].left = stay;
+	nodes[a].right = given;
+	nodes[given].parent = a;
+
+	refit(a);
+	refit(up);
+	return up;
+}
+
+void AABBTree::query(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<unsigned int> &ids)
+{
+	if (root == -1)
+		return;
+
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		if (!overlaps(boundsMin, boundsMax, node.boundsMin, node.boundsMax))
+			continue;
+
+		if (node.left == -1)
+		{
+			if (overlaps(boundsMin, boundsMax, node.exactMin, node.exactMax))
+				ids.push_back(node.id);
+			continue;
+		}
+		stack.push_back(node.left);
+		stack.push_back(node.right);
+	}
+}
+
+bool AABBTree::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit)
+{
+	if (root == -1)
+		return false;
+
+	//a zero component gives an infinite inverse, which the slab test handles
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float closest = maxDistance;
+	bool found = false;
+	float enter;
+
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		if (!rayHitsBox(origin, inverseDirection, closest, node.boundsMin, node.boundsMax, enter))
+			continue;
+
+		if (node.left == -1)
+		{
+			if (rayHitsBox(origin, inverseDirection, closest, node.exactMin, node.exactMax, enter))
+			{
+				closest = enter;
+				hit.id = node.id;
+				found = true;
+			}
+			continue;
+		}
+
+		//nearer child on top, so it is searched first and shortens the ray for the other one
+		float enterLeft, enterRight;
+		bool hitsLeft = rayHitsBox(origin, inverseDirection, closest, nodes[node.left].boundsMin, nodes[node.left].boundsMax, enterLeft);
+		bool hitsRight = rayHitsBox(origin, inverseDirection, closest, nodes[node.right].boundsMin, nodes[node.right].boundsMax, enterRight);
+		int left = node.left, right = node.right;
+		if (hitsLeft && hitsRight)
+		{
+			stack.push_back(enterLeft < enterRight ? right : left);
+			stack.push_back(enterLeft < enterRight ? left : right);
+		}
+		else if (hitsLeft)
+			stack.push_back(left);
+		else if (hitsRight)
+			stack.push_back(right);
+	}
+
+	if (found)
+	{
+		hit.distance = closest;
+		hit.point = origin + direction * closest;
+	}
+	return found;
+}
+
+size_t AABBTree::size()
+{
+	return leaves.size();
+}
+
+int AABBTree::getHeight()
+{
+	return root == -1 ? 0 : nodes[root].height;
+}
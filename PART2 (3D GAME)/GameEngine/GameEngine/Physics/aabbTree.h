@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <glm.hpp>
+
+//closest box along a ray
+struct RayHit
+{
+	unsigned int id;
+	float distance;
+	glm::vec3 point;
+};
+
+//dynamic bounding volume hierarchy: every box is a leaf, every inner node holds the box around its two children;
+//inserts go where they grow the tree's surface area the least and rotations keep it balanced, so queries and
+//updates cost about log n; leaves are fattened by margin so boxes moving a little need no update
+class AABBTree
+{
+	public:
+		AABBTree(float margin = 0.0f);
+
+		//ids are chosen by the caller and have to stay unique while inserted
+		void insert(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+		void remove(unsigned int id);
+		//refits the box; the tree only changes when it leaves its fattened leaf
+		void move(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+		void clear();
+
+		//appends every id whose box overlaps the query box
+		void query(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<unsigned int> &ids);
+		//first box hit by the ray within maxDistance, direction has to be normalized; a segment is a ray with
+		//its length as maxDistance, which also answers line of sight
+		bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit);
+
+		size_t size();
+		int getHeight();
+
+	private:
+		struct Node
+		{
+			glm::vec3 boundsMin, boundsMax;       //fattened for leaves
+			glm::vec3 exactMin, exactMax;         //leaves only
+			int parent;                           //next free node while unused
+			int left, right;                      //-1 for leaves
+			int height;                           //0 for leaves
+			unsigned int id;
+		};
+
+		float margin;
+		std::vector<Node> nodes;
+		int root;
+		int freeNodes;
+		std::unordered_map<unsigned int, int> leaves;
+		std::vector<int> stack;
+
+		int allocateNode();
+		void freeNode(int node);
+		void insertLeaf(int leaf);
+		void removeLeaf(int leaf);
+		int balance(int node);
+		void refit(int node);
+};
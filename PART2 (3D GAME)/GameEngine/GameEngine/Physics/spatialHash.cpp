@@ -0,0 +1,105 @@
+#include "spatialHash.h"
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize)
+{
+	this->cellSize = cellSize;
+}
+
+glm::ivec3 SpatialHash::cellOf(const glm::vec3 &point)
+{
+	return glm::ivec3((int)floorf(point.x / cellSize), (int)floorf(point.y / cellSize), (int)floorf(point.z / cellSize));
+}
+
+//21 bits per axis, cells a million apart share a key but are told apart by the box test
+uint64_t SpatialHash::cellKey(int x, int y, int z)
+{
+	return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) | (uint64_t)(z & 0x1FFFFF);
+}
+
+void SpatialHash::insert(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+	Entry entry = { id, boundsMin, boundsMax };
+	entries[id] = entry;
+
+	glm::ivec3 low = cellOf(boundsMin);
+	glm::ivec3 high = cellOf(boundsMax);
+	for (int x = low.x; x <= high.x; x++)
+		for (int y = low.y; y <= high.y; y++)
+			for (int z = low.z; z <= high.z; z++)
+				cells[cellKey(x, y, z)].push_back(entry);
+}
+
+void SpatialHash::remove(unsigned int id)
+{
+	auto found = entries.find(id);
+	if (found == entries.end())
+		return;
+
+	glm::ivec3 low = cellOf(found->second.boundsMin);
+	glm::ivec3 high = cellOf(found->second.boundsMax);
+	for (int x = low.x; x <= high.x; x++)
+		for (int y = low.y; y <= high.y; y++)
+			for (int z = low.z; z <= high.z; z++)
+			{
+				auto cell = cells.find(cellKey(x, y, z));
+				if (cell == cells.end())
+					continue;
+
+				//order inside a cell does not matter, swap with the last and pop
+				std::vector<Entry> &cellEntries = cell->second;
+				for (size_t i = 0; i < cellEntries.size(); i++)
+				{
+					if (cellEntries[i].id == id)
+					{
+						cellEntries[i] = cellEntries.back();
+						cellEntries.pop_back();
+						break;
+					}
+				}
+				if (cellEntries.empty())
+					cells.erase(cell);
+			}
+
+	entries.erase(found);
+}
+
+void SpatialHash::clear()
+{
+	cells.clear();
+	entries.clear();
+}
+
+void SpatialHash::query(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<unsigned int> &ids)
+{
+	glm::ivec3 low = cellOf(boundsMin);
+	glm::ivec3 high = cellOf(boundsMax);
+	for (int x = low.x; x <= high.x; x++)
+		for (int y = low.y; y <= high.y; y++)
+			for (int z = low.z; z <= high.z; z++)
+			{
+				auto cell = cells.find(cellKey(x, y, z));
+				if (cell == cells.end())
+					continue;
+
+				for (size_t i = 0; i < cell->second.size(); i++)
+				{
+					const Entry &entry = cell->second[i];
+					if (boundsMin.x > entry.boundsMax.x || boundsMax.x < entry.boundsMin.x ||
+						boundsMin.y > entry.boundsMax.y || boundsMax.y < entry.boundsMin.y ||
+						boundsMin.z > entry.boundsMax.z || boundsMax.z < entry.boundsMin.z)
+						continue;
+
+					//boxes spanning several cells are met several times, they are reported only from the
+					//cell holding the low corner of where the two boxes overlap, which is visited exactly once
+					glm::ivec3 corner = cellOf(glm::max(boundsMin, entry.boundsMin));
+					if (corner.x == x && corner.y == y && corner.z == z)
+						ids.push_back(entry.id);
+				}
+			}
+}
+
+size_t SpatialHash::size()
+{
+	return entries.size();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm.hpp>
+
+//broadphase: boxes are filed under every grid cell they overlap, a query only looks at the cells
+//its own box overlaps, so its cost depends on how crowded the neighbourhood is, not on the total
+class SpatialHash
+{
+	public:
+		SpatialHash(float cellSize);
+
+		//ids are chosen by the caller and have to stay unique while inserted
+		void insert(unsigned int id, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+		void remove(unsigned int id);
+		void clear();
+
+		//appends every id whose box overlaps the query box, each one once
+		void query(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<unsigned int> &ids);
+		size_t size();
+
+	private:
+		//cells keep a copy of the box, so a query never has to look the id up
+		struct Entry
+		{
+			unsigned int id;
+			glm::vec3 boundsMin, boundsMax;
+		};
+
+		float cellSize;
+		std::unordered_map<uint64_t, std::vector<Entry>> cells;
+		std::unordered_map<unsigned int, Entry> entries;
+
+		glm::ivec3 cellOf(const glm::vec3 &point);
+		static uint64_t cellKey(int x, int y, int z);
+};
@@ -0,0 +1,74 @@
+#include "sweep.h"
+#include <cmath>
+
+//the moving box shrinks to its center and the other box grows by its half extents, which leaves a segment against a box
+bool sweepBox(const glm::vec3 &start, const glm::vec3 &end, const glm::vec3 &halfExtents,
+	const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float &timeOfImpact)
+{
+	glm::vec3 grownMin = boundsMin - halfExtents;
+	glm::vec3 grownMax = boundsMax + halfExtents;
+	glm::vec3 motion = end - start;
+
+	float enter = 0.0f;
+	float exit = 1.0f;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		//not moving along this axis, the slab is either always or never overlapped
+		if (fabsf(motion[axis]) < 1e-8f)
+		{
+			if (start[axis] < grownMin[axis] || start[axis] > grownMax[axis])
+				return false;
+			continue;
+		}
+
+		float t1 = (grownMin[axis] - start[axis]) / motion[axis];
+		float t2 = (grownMax[axis] - start[axis]) / motion[axis];
+		if (t1 > t2)
+		{
+			float swap = t1;
+			t1 = t2;
+			t2 = swap;
+		}
+
+		enter = t1 > enter ? t1 : enter;
+		exit = t2 < exit ? t2 : exit;
+		if (enter > exit)
+			return false;
+	}
+
+	timeOfImpact = enter;
+	return true;
+}
+
+//the same for spheres: a segment against one sphere with both radii
+bool sweepSphere(const glm::vec3 &start, const glm::vec3 &end, float radius,
+	const glm::vec3 &center, float otherRadius, float &timeOfImpact)
+{
+	float combined = radius + otherRadius;
+	glm::vec3 motion = end - start;
+	glm::vec3 offset = start - center;
+
+	float c = glm::dot(offset, offset) - combined * combined;
+	if (c <= 0.0f)
+	{
+		timeOfImpact = 0.0f;
+		return true;
+	}
+
+	//t^2 a + 2 t b + c = 0, the smaller root is where the spheres first touch
+	float a = glm::dot(motion, motion);
+	float b = glm::dot(offset, motion);
+	if (a < 1e-12f || b >= 0.0f)
+		return false;
+
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+		return false;
+
+	float t = (-b - sqrtf(discriminant)) / a;
+	if (t > 1.0f)
+		return false;
+
+	timeOfImpact = t;
+	return true;
+}
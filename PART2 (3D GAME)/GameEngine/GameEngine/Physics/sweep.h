@@ -0,0 +1,13 @@
+#pragma once
+#include <glm.hpp>
+
+//continuous tests for something moving from start to end during one step; timeOfImpact is the fraction
+//of the way (0 to 1) at which it first touches, 0 when it already overlaps at the start
+
+//box with the given half extents centered on the moving point, against a box that stays in place
+bool sweepBox(const glm::vec3 &start, const glm::vec3 &end, const glm::vec3 &halfExtents,
+	const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float &timeOfImpact);
+
+//sphere centered on the moving point, against a sphere that stays in place
+bool sweepSphere(const glm::vec3 &start, const glm::vec3 &end, float radius,
+	const glm::vec3 &center, float otherRadius, float &timeOfImpact);
@@ -2,10 +2,12 @@
 out vec4 FragColor;
 
 in vec2 TexCoords; 
+flat in float Layer;
 
-uniform sampler2D texture1; 
+// every planet skin in one array, so planets with different skins still draw together
+uniform sampler2DArray texture_array1; 
 
 void main()
 {
-    FragColor = texture(texture1, TexCoords); 
+    FragColor = texture(texture_array1, vec3(TexCoords, Layer)); 
 }
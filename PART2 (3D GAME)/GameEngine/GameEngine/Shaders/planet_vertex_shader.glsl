@@ -2,13 +2,24 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aModel;   // per instance, locations 3 to 6
+layout (location = 7) in float aLayer;  // per instance, which skin of the texture array
 
 out vec2 TexCoords; 
+flat out float Layer;
 
-uniform mat4 MVP; 
+uniform mat4 viewProjection; 
+
+// packed meshes store positions and texture coordinates relative to their bounds
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec2 textureScale;
+uniform vec2 textureOffset;
 
 void main()
 {
-    gl_Position = MVP * vec4(aPos, 1.0);
-    TexCoords = aTexCoord; 
+    vec3 position = aPos * positionScale + positionOffset;
+    gl_Position = viewProjection * aModel * vec4(position, 1.0);
+    TexCoords = aTexCoord * textureScale + textureOffset; 
+    Layer = aLayer;
 }
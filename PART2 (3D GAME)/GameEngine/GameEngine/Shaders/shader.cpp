@@ -1,9 +1,17 @@
 #include "shader.h"
 #include <iostream>
 #include <vector>
+#include <unordered_map>
 
 using namespace std;
 
+//location cache entries not asked from GL yet
+static const int unresolvedLocation = -2;
+
+//interned uniform names, the id of a name is its index
+static std::unordered_map<std::string, unsigned int> uniformIds;
+static std::vector<std::string> uniformNames;
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
 	std::string vertexCode;
@@ -109,6 +117,35 @@ int Shader::getId()
 	return id;
 }
 
+unsigned int Shader::uniformId(const std::string &name)
+{
+	auto found = uniformIds.find(name);
+	if (found != uniformIds.end())
+		return found->second;
+
+	unsigned int newId = uniformNames.size();
+	uniformIds[name] = newId;
+	uniformNames.push_back(name);
+	return newId;
+}
+
+int Shader::getUniformLocation(unsigned int uniformId)
+{
+	if (uniformId >= uniformLocations.size())
+		uniformLocations.resize(uniformId + 1, unresolvedLocation);
+
+	//-1 (not used by this program) is cached as well
+	if (uniformLocations[uniformId] == unresolvedLocation)
+		uniformLocations[uniformId] = glGetUniformLocation(id, uniformNames[uniformId].c_str());
+
+	return uniformLocations[uniformId];
+}
+
+int Shader::getUniformLocation(const std::string &name)
+{
+	return getUniformLocation(uniformId(name));
+}
+
 Shader::~Shader()
 {
 }
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 class Shader
 {
@@ -14,7 +15,14 @@ public:
 	void use();
 	int getId();
 
+	//uniform names are interned once into small ids shared by every shader,
+	//looking up a location by id is then an array index instead of a GL call
+	static unsigned int uniformId(const std::string &name);
+	int getUniformLocation(unsigned int uniformId);
+	int getUniformLocation(const std::string &name);
+
 private:
 	unsigned int id;
+	std::vector<int> uniformLocations;
 };
 
@@ -11,10 +11,30 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// packed meshes store positions and texture coordinates relative to their bounds
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform vec2 textureScale;
+uniform vec2 textureOffset;
+uniform bool octahedralNormals;
+
+// unfolds a normal stored on the octahedron back onto the sphere
+vec3 decodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoord = aTexCoord;
+    vec3 position = aPos * positionScale + positionOffset;
+    vec3 normal = octahedralNormals ? decodeOctahedral(aNormal.xy) : aNormal;
+
+    FragPos = vec3(model * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(model))) * normal;
+    TexCoord = aTexCoord * textureScale + textureOffset;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
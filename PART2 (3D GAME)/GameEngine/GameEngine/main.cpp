@@ -1,11 +1,24 @@
 #include "Graphics/window.h"
+#include "Graphics/instanceBuffer.h"
 #include "Camera/camera.h"
+#include "Camera/frustumCuller.h"
 #include "Shaders/shader.h"
 #include "Model Loading/mesh.h"
+#include "Model Loading/material.h"
 #include "Model Loading/texture.h"
 #include "Model Loading/meshLoaderObj.h"
+#include "Model Loading/assetLoader.h"
+#include "Physics/spatialHash.h"
+#include "Physics/aabbTree.h"
+#include "Physics/sweep.h"
+#include "Game/world.h"
+#include "Game/systems.h"
+#include "Game/sectorStreamer.h"
+#include "Jobs/jobSystem.h"
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <filesystem>
 
 Window window("Cosmic Revolution", 1000, 1000);
 Camera camera;
@@ -16,23 +29,31 @@ float score = 0;                            // score, of course
 float planetRotationSpeed = 5.0f;           // rotation speed for generated planets
 float deltaTime = 0.0f;                     // amount of time between current frame and last frame
 float lastFrame = 0.0f;                     // timestamp of last rendered frame
+const float simulationStep = 1.0f / 120.0f; // the simulation always advances by exactly this much
+const int maxSubsteps = 8;                  // simulation steps per frame at most, a longer hitch slows the game down instead
+float simulationTime = 0.0f;                // simulated time since the start
+glm::vec3 previousCameraPosition;           // camera position before the last simulation step
 float boundingBoxScaleFactor = 3.0f;        // scale factor for generated planets bounding box
 float thrusterLength = 0.0f;                // thruster length
 float forwardSpeed = 50.0f;                 // initial speed of the spaceship
 float timeElapsed = 0.0f;                   // game duration
-const float planetRangeMin = -1000.0f;      // minimum range for spawning planets
-const float planetRangeMax = 1000.0f;       // maximum range for spawning planets
 const float planetMinScale = 10.0f;          // minimum size for a planet
 const float planetMaxScale = 15.0f;         // maximum size for a planet
-int numPlanets = 45;                        // initial number of planets
-std::vector<glm::vec3> planetPositions;     // vector for random planet positions
-std::vector<float> planetScales;            // vector for random planet sizes
-glm::vec3 lastCameraPosition = camera.getCameraPosition();  // save the last position of the camera
+const float planetsPerSector = 14.0f;       // planets in a sector near the start, twice as many far out
+const float sectorRampDistance = 30000.0f;  // distance from the start at which sectors are the most crowded
+const float startClearance = 300.0f;        // no planets this close to the starting point
+const float shotCooldown = 0.25f;           // simulated seconds between shots while SPACE is held
+float nextShotTime = 0.0f;                  // simulation time at which the next shot may fire
+World world;                                // planets, the spaceship and its thrusters
+Entity spaceshipEntity;                     // flies in front of the camera
+Entity thrusterEntities[2];                 // left and right thruster flames
+int planetCount = 0;                        // planets alive in the world
+SectorStreamer sectors(1000.0f, 48);        // 1000 unit sectors streamed around the camera, at most 48 loaded
+enum RenderModel { MODEL_PLANET, MODEL_SPACESHIP, MODEL_THRUSTER, MODEL_COUNT };    // what Renderable::model refers to
+unsigned int planetSkinCount = 1;           // layers of the planet texture array, each planet picks one
 
 // functions (declared at the end of the code)
 void processKeyboardInput();
-glm::vec3 generateRandomPosition(float rangeMin, float rangeMax);
-float generateRandomScale(float minScale, float maxScale);
 struct AABB {
     glm::vec3 min;
     glm::vec3 max;
@@ -47,19 +68,20 @@ struct AABB {
             (min.y <= other.max.y && max.y >= other.min.y) &&
             (min.z <= other.max.z && max.z >= other.min.z);
     }
-    bool intersectsXY(const glm::vec3& point) const {
-        return (point.x >= min.x && point.x <= max.x) &&
-            (point.y >= min.y && point.y <= max.y);
-    }
 };
-AABB getSpaceshipBoundingBox(const glm::mat4& model);
-std::vector<AABB> planetBoundingBoxes;
+SpatialHash planetGrid(128.0f);             // broadphase over the planet bounds by entity index, cells wider than the largest box
+AABBTree planetTree;                        // the same bounds in a bounding volume hierarchy, for ray queries (shooting)
+const float shotRange = 10000.0f;           // how far a shot reaches
+void removePlanet(Entity planet);
+void updateSpaceship();
 void checkCollisions();
-void generatePlanets(int numPlanets, float rangeMin, float rangeMax, float minScale, float maxScale);
+void loadSector(Sector& sector, SectorRandom& random);
+void unloadSector(Sector& sector);
 void updatePlanets();
 void resetGame();
+std::vector<std::string> findPlanetSkins(const std::string& directory);
 
-int main()
+int main(int argc, char** argv)
 {
     // setting the position of the camera such that it gives a nice viewing angle of the spaceship
     camera.setPosition(glm::vec3(0.0f, 5.0f, 20.0f)); 
@@ -75,7 +97,13 @@ int main()
         "Resources/Skybox/front.png",
         "Resources/Skybox/back.png"
     };
-    GLuint skyboxTexture = loadCubemap(skyboxFaces);
+    // per-frame simulation and render preparation, split into jobs over every core
+    JobSystem jobs;
+    // assets are decoded on worker threads and uploaded a few at a time from the main loop;
+    // large models are parsed in chunks on the job system, which is still idle while they load
+    AssetLoader assets;
+    assets.setJobSystem(&jobs);
+    TextureHandle skyboxTexture = assets.loadCubemap(skyboxFaces);
     float skyboxVertices[] = {
         -1.0f,  1.0f, -1.0f,
         -1.0f, -1.0f, -1.0f,
@@ -127,28 +155,109 @@ int main()
     Shader skyboxShader("Shaders/skybox_vertex_shader.glsl", "Shaders/skybox_fragment_shader.glsl");
     Shader spaceshipShader("Shaders/spaceship_vertex_shader.glsl", "Shaders/spaceship_fragment_shader.glsl");
     Shader planetShader("Shaders/planet_vertex_shader.glsl", "Shaders/planet_fragment_shader.glsl");
-    GLuint spaceshipTexture = loadBMP("Resources/Textures/spaceship_texture.bmp");
+    TextureHandle spaceshipTexture = assets.loadTexture("Resources/Textures/spaceship_texture.bmp");
     std::vector<Texture> textures;
     textures.push_back(Texture());
-    textures[0].id = spaceshipTexture;
+    textures[0].id = spaceshipTexture.getId();
     textures[0].type = "texture_diffuse";
-    GLuint planetTexture = loadBMP("Resources/Textures/planet2.bmp");
+    // every planet skin is a layer of one array, so all planets still share one texture and draw together
+    std::vector<std::string> planetSkins = findPlanetSkins("Resources/Textures");
+    planetSkinCount = planetSkins.size();
+    TextureHandle planetTexture = assets.loadTextureArray(planetSkins);
     std::vector<Texture> textures2;
     textures2.push_back(Texture());
-    textures2[0].id = planetTexture;
-    textures2[0].type = "texture_diffuse";
-    MeshLoaderObj loader;
-    Mesh planet = loader.loadObj("Resources/Models/sphere3.obj", textures2);
-    Mesh spaceship = loader.loadObj("Resources/Models/spaceship.obj", textures);
-    Mesh sphere = loader.loadObj("Resources/Models/sphere.obj");
-
-    //random seed for number generator
-    srand(static_cast<unsigned int>(time(0))); 
-
-    //first set of planets generated before the game starts
-    generatePlanets(numPlanets, planetRangeMin, planetRangeMax, planetMinScale, planetMaxScale);
+    textures2[0].id = planetTexture.getId();
+    textures2[0].type = "texture_array";
+    textures2[0].target = GL_TEXTURE_2D_ARRAY;
+    MeshHandle planet = assets.loadMesh("Resources/Models/sphere3.obj", textures2);
+    MeshHandle spaceship = assets.loadMesh("Resources/Models/spaceship.obj", textures);
+    MeshHandle sphere = assets.loadMesh("Resources/Models/sphere.obj");
+
+    // uniform locations and materials are resolved once, the loop only sets values
+    GLint skyboxViewLoc = skyboxShader.getUniformLocation("view");
+    GLint skyboxProjLoc = skyboxShader.getUniformLocation("projection");
+    GLint planetViewProjectionLoc = planetShader.getUniformLocation("viewProjection");
+    GLint spaceshipTimeLoc = spaceshipShader.getUniformLocation("time");
+    GLint spaceshipViewLoc = spaceshipShader.getUniformLocation("view");
+    GLint spaceshipProjLoc = spaceshipShader.getUniformLocation("projection");
+    GLint spaceshipModelLoc = spaceshipShader.getUniformLocation("model");
+    GLint spaceshipIsThrusterLoc = spaceshipShader.getUniformLocation("isThruster");
+    GLint spaceshipThrusterColorLoc = spaceshipShader.getUniformLocation("thrusterColor");
+    Material planetMaterial(planetShader, planet.get());
+    Material spaceshipMaterial(spaceshipShader, spaceship.get());
+    Material thrusterMaterial(spaceshipShader, sphere.get());
+
+    // planet model matrices and skin layers, sorted by level of detail and uploaded once per frame
+    InstanceBuffer planetInstances;
+    InstanceBuffer planetLayerInstances;
+    std::vector<glm::mat4> planetModels;
+    std::vector<glm::mat4> planetModelsByLod;
+    std::vector<float> planetLayers;
+    std::vector<float> planetLayersByLod;
+    std::vector<unsigned int> planetLods;
+    std::vector<unsigned int> planetLodFirst;
+
+    // planet bounding spheres gathered from the world, and the ones inside the camera frustum
+    SphereBatch planetSpheres;
+    std::vector<const Transform*> planetTransforms;
+    std::vector<unsigned int> planetSkinLayers;
+    std::vector<unsigned int> visiblePlanets;
+    std::vector<std::vector<unsigned int>> visiblePlanetRanges;
+    std::vector<CullStats> planetRangeStats;
+    CullStats planetCullStats = { 0, 0 };
+
+    // entities: the planets reserve their chunks up front, the spaceship and thrusters exist for the whole game
+    MeshHandle* renderMeshes[MODEL_COUNT] = { &planet, &spaceship, &sphere };
+    Material* renderMaterials[MODEL_COUNT] = { &planetMaterial, &spaceshipMaterial, &thrusterMaterial };
+    world.reserve<Transform, Rotator, Collider, Bounds, Renderable>(sectors.getCapacity() * MAX_SECTOR_ENTITIES);
+    Transform spaceshipTransform = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.1f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, glm::mat4(1.0f) };
+    Collider spaceshipCollider = { 1.0f };
+    Bounds spaceshipBounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+    Renderable spaceshipRenderable = { MODEL_SPACESHIP, 0, 0 };
+    spaceshipEntity = world.create(spaceshipTransform, spaceshipCollider, spaceshipBounds, spaceshipRenderable);
+    Renderable thrusterRenderable = { MODEL_THRUSTER, RENDER_THRUSTER, 0 };
+    for (int i = 0; i < 2; ++i)
+        thrusterEntities[i] = world.create(spaceshipTransform, thrusterRenderable);
+    float lastTimingReport = 0.0f;
+
+    // the seed decides every sector, pass one on the command line to replay a run
+    uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 10) : static_cast<uint64_t>(time(0));
+    std::cout << "Seed: " << seed << std::endl;
+    sectors.setSeed(seed);
+    sectors.setRange(4000.0f, 1000.0f, 1000.0f);
     glEnable(GL_DEPTH_TEST);
 
+    // drawing is throttled to the display, the simulation runs at its own fixed rate either way
+    window.setVSync(true);
+    float accumulator = 0.0f;
+    previousCameraPosition = camera.getCameraPosition();
+
+    // one fixed step: input, movement and every simulation system
+    auto simulate = [&]() {
+        simulationTime += simulationStep;
+        previousCameraPosition = camera.getCameraPosition();
+        world.runSystem("snapshot", [&]() { snapshotSystem(world, jobs); });
+        processKeyboardInput();
+
+        timeElapsed += simulationStep;
+        camera.setPosition(camera.getCameraPosition() + horizontalDirection * forwardSpeed * simulationStep);
+        if (gameOver == false) {
+            forwardSpeed = glm::min(5000.0f, 50.0f + 25.0f * timeElapsed);  // Cap speed at 1000
+            score += (timeElapsed / 1000.0f + forwardSpeed / 500) * simulationStep * 60.0f;  // tuned per frame at 60 fps
+            if (score < 0.0f)
+                score = 0.0f;
+        }
+        else {
+            forwardSpeed = 25.0f;
+            planetRotationSpeed = 0;
+        }
+
+        updateSpaceship();
+        world.runSystem("spawn", updatePlanets);
+        world.runSystem("bounds", [&]() { boundsSystem(world, jobs); });
+        world.runSystem("collide", checkCollisions);
+    };
+
     //main loop
     while (!window.isPressed(GLFW_KEY_ESCAPE) && glfwWindowShouldClose(window.getWindow()) == 0)
     {
@@ -157,19 +266,36 @@ int main()
         float currentFrame = glfwGetTime(); // current time since the start of application
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-        processKeyboardInput();
+        assets.processUploads(2.0);
+
+        // simulation: as many fixed steps as the frame took, the time left over carries to the next frame
+        accumulator += deltaTime;
+        int substeps = 0;
+        while (accumulator >= simulationStep && substeps < maxSubsteps) {
+            simulate();
+            accumulator -= simulationStep;
+            ++substeps;
+        }
+        if (accumulator >= simulationStep)
+            accumulator = fmod(accumulator, simulationStep);
+
+        // the frame is drawn the left over fraction of a step past the last simulated state
+        float blend = accumulator / simulationStep;
+        glm::vec3 simulatedCameraPosition = camera.getCameraPosition();
+        camera.setPosition(glm::mix(previousCameraPosition, simulatedCameraPosition, blend));
+        float renderTime = simulationTime - simulationStep * (1.0f - blend);
+        world.runSystem("rotate", [&]() { rotatorSystem(world, jobs, planetRotationSpeed * renderTime); });
+        world.runSystem("transform", [&]() { transformSystem(world, jobs, blend); });
 
         // skybox
         glDepthFunc(GL_LEQUAL);
         skyboxShader.use();
         glm::mat4 view = glm::mat4(glm::mat3(camera.getViewMatrix()));
         glm::mat4 projection = glm::perspective(glm::degrees(90.0f), (float)window.getWidth() / window.getHeight(), 0.1f, 100.0f);
-        GLuint viewLoc = glGetUniformLocation(skyboxShader.getId(), "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-        GLuint projLoc = glGetUniformLocation(skyboxShader.getId(), "projection");
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
+        glUniformMatrix4fv(skyboxViewLoc, 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(skyboxProjLoc, 1, GL_FALSE, &projection[0][0]);
         glBindVertexArray(skyboxVAO);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture.getId());
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
         glDepthFunc(GL_LESS);
@@ -178,88 +304,122 @@ int main()
         planetShader.use();
         projection = glm::perspective(glm::degrees(45.0f), (float)window.getWidth() / window.getHeight(), 0.1f, 10000.0f);
         view = camera.getViewMatrix();
-        GLuint MatrixID = glGetUniformLocation(planetShader.getId(), "MVP");
-
-        // generating planets constantly
-        for (int i = 0; i < planetPositions.size(); ++i) {
-            updatePlanets();    
-            glm::vec3 planetPos = planetPositions[i];  
-            float scale = planetScales[i];  
-            float rotationAngle = planetRotationSpeed * currentFrame;  
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, planetPos);  
-            model = glm::rotate(model, glm::degrees(rotationAngle), glm::vec3(1.0f, 0.0f, 0.0f));  
-            model = glm::scale(model, glm::vec3(scale));  
-            glm::mat4 MVP = projection * view * model; 
-            glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-            checkCollisions();
-            planet.draw(planetShader);
+        glm::mat4 viewProjection = projection * view;
+        glUniformMatrix4fv(planetViewProjectionLoc, 1, GL_FALSE, &viewProjection[0][0]);
+        float pixelsPerUnit = glm::abs(projection[1][1]) * window.getHeight() * 0.5f;   // size in pixels of one unit seen from distance 1
+        glm::vec3 cameraPos = camera.getCameraPosition();
+        Mesh &planetMesh = planet.get();
+
+        // the mesh rotates around its origin, so the sphere around the origin holding its bounds holds every rotation
+        float planetMeshRadius = glm::length(glm::max(glm::abs(planetMesh.boundsMin), glm::abs(planetMesh.boundsMax)));
+        camera.updateFrustum(projection);
+        world.runSystem("cull", [&]() {
+            planetSpheres.clear();
+            planetTransforms.clear();
+            planetSkinLayers.clear();
+            world.each<Transform, Renderable>([&](Entity, Transform& transform, Renderable& renderable) {
+                if (renderable.flags & RENDER_INSTANCED) {
+                    planetSpheres.push(transform.position, transform.scale.x);
+                    planetTransforms.push_back(&transform);
+                    planetSkinLayers.push_back(renderable.layer);
+                }
+            });
+
+            // one range per thread, each culled into its own list and joined in order afterwards
+            unsigned int sphereCount = planetSpheres.size();
+            unsigned int ranges = glm::min(jobs.getThreadCount(), sphereCount / 64 + 1);
+            visiblePlanetRanges.resize(ranges);
+            planetRangeStats.resize(ranges);
+            JobCounter culled;
+            for (unsigned int r = 0; r < ranges; ++r) {
+                unsigned int first = sphereCount * r / ranges;
+                unsigned int last = sphereCount * (r + 1) / ranges;
+                jobs.run([&, r, first, last]() {
+                    visiblePlanetRanges[r].clear();
+                    cullSpheres(camera.getFrustumPlanes(), planetSpheres, first, last, planetMeshRadius, visiblePlanetRanges[r], planetRangeStats[r]);
+                }, &culled);
+            }
+            jobs.wait(culled);
+
+            visiblePlanets.clear();
+            planetCullStats.tested = sphereCount;
+            planetCullStats.visible = 0;
+            for (unsigned int r = 0; r < ranges; ++r) {
+                visiblePlanets.insert(visiblePlanets.end(), visiblePlanetRanges[r].begin(), visiblePlanetRanges[r].end());
+                planetCullStats.visible += planetRangeStats[r].visible;
+            }
+        });
+
+        // model matrices, skins and levels of detail of the visible planets, filled in parallel
+        planetModels.resize(visiblePlanets.size());
+        planetLayers.resize(visiblePlanets.size());
+        planetLods.resize(visiblePlanets.size());
+        JobCounter prepared;
+        jobs.parallelFor(visiblePlanets.size(), 64, [&](unsigned int begin, unsigned int end) {
+            for (unsigned int v = begin; v < end; ++v) {
+                const Transform& transform = *planetTransforms[visiblePlanets[v]];
+                planetModels[v] = transform.model;
+                planetLayers[v] = (float)planetSkinLayers[visiblePlanets[v]];
+                planetLods[v] = planetMesh.selectLod(glm::length(transform.position - cameraPos), transform.scale.x, pixelsPerUnit);
+            }
+        }, prepared);
+        jobs.wait(prepared);
+
+        // counting sort by level so every level is one range of the instance buffer and one draw call
+        planetLodFirst.assign(planetMesh.lods.size() + 1, 0);
+        for (size_t i = 0; i < planetLods.size(); ++i)
+            planetLodFirst[planetLods[i] + 1]++;
+        for (size_t lod = 1; lod < planetLodFirst.size(); ++lod)
+            planetLodFirst[lod] += planetLodFirst[lod - 1];
+        planetModelsByLod.resize(planetModels.size());
+        planetLayersByLod.resize(planetLayers.size());
+        for (size_t i = 0; i < planetModels.size(); ++i) {
+            planetModelsByLod[planetLodFirst[planetLods[i]]] = planetModels[i];
+            planetLayersByLod[planetLodFirst[planetLods[i]]++] = planetLayers[i];
         }
+        for (size_t lod = planetLodFirst.size() - 1; lod > 0; --lod)
+            planetLodFirst[lod] = planetLodFirst[lod - 1];
+        planetLodFirst[0] = 0;
+
+        planetInstances.upload(planetModelsByLod.data(), planetModelsByLod.size() * sizeof(glm::mat4));
+        planetLayerInstances.upload(planetLayersByLod.data(), planetLayersByLod.size() * sizeof(float));
+        for (unsigned int lod = 0; lod + 1 < planetLodFirst.size(); ++lod)
+            planetMesh.drawInstanced(planetMaterial, lod, planetInstances.getId(), planetLodFirst[lod], planetLodFirst[lod + 1] - planetLodFirst[lod], planetLayerInstances.getId());
 
-        // spaceship
+        // spaceship and thrusters
         spaceshipShader.use();
-        glUniform1f(glGetUniformLocation(spaceshipShader.getId(), "time"), currentFrame);
+        glUniform1f(spaceshipTimeLoc, currentFrame);
         view = camera.getViewMatrix();
         projection = glm::perspective(glm::degrees(45.0f), (float)window.getWidth() / window.getHeight(), 0.1f, 100.0f);
-        GLuint viewLocSpaceship = glGetUniformLocation(spaceshipShader.getId(), "view");
-        glUniformMatrix4fv(viewLocSpaceship, 1, GL_FALSE, &view[0][0]);
-        GLuint projLocSpaceship = glGetUniformLocation(spaceshipShader.getId(), "projection");
-        glUniformMatrix4fv(projLocSpaceship, 1, GL_FALSE, &projection[0][0]);
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, camera.getCameraPosition() + camera.getCameraViewDirection() * 10.0f);  
-        model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-        GLuint modelLocSpaceship = glGetUniformLocation(spaceshipShader.getId(), "model");
-        glUniformMatrix4fv(modelLocSpaceship, 1, GL_FALSE, &model[0][0]);
-        glUniform1i(glGetUniformLocation(spaceshipShader.getId(), "isThruster"), false);
-        glUniform3fv(glGetUniformLocation(spaceshipShader.getId(), "thrusterColor"), 1, glm::value_ptr(glm::vec3(0.0f, 0.0f, 0.0f)));  
-        spaceship.draw(spaceshipShader);
-
-        // thrusters
-        thrusterLength += deltaTime * 5.0f; 
-        if (thrusterLength > 0.01f) {
-            thrusterLength = 0.01f;
-        }
-        glm::mat4 spaceshipModel = glm::mat4(1.0f); 
-        spaceshipModel = glm::translate(spaceshipModel, camera.getCameraPosition() + camera.getCameraViewDirection() * 10.0f);
-        glm::vec3 spaceshipPosition = glm::vec3(spaceshipModel[3]); 
-        glm::vec3 thrusterPosition = spaceshipPosition - camera.getCameraRightDirection() * 0.39f - camera.getCameraViewDirection() * 1.5f - camera.getCameraUp() * 0.125f;
-        glm::vec3 thrusterPosition2 = spaceshipPosition + camera.getCameraRightDirection() * 0.39f - camera.getCameraViewDirection() * 1.5f - camera.getCameraUp() * 0.125f; 
+        glUniformMatrix4fv(spaceshipViewLoc, 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(spaceshipProjLoc, 1, GL_FALSE, &projection[0][0]);
         glm::vec3 thrusterColor = glm::vec3(1.0f, 0.2f, 0.0f); 
-        spaceshipShader.use();
-        glm::mat4 thrusterModel = glm::mat4(1.0f);
-        thrusterModel = glm::translate(thrusterModel, thrusterPosition);  
-        float pulse = 0.05f + 0.5f * sin(glfwGetTime() * 5.0f); 
-        thrusterModel = glm::scale(thrusterModel, glm::vec3(0.005f, thrusterLength * pulse, 0.005f));
-        GLuint modelLocThruster = glGetUniformLocation(spaceshipShader.getId(), "model");
-        glUniformMatrix4fv(modelLocThruster, 1, GL_FALSE, &thrusterModel[0][0]);
-        glUniform3fv(glGetUniformLocation(spaceshipShader.getId(), "thrusterColor"), 1, &thrusterColor[0]);
-        glUniform1i(glGetUniformLocation(spaceshipShader.getId(), "isThruster"), true);
-        sphere.draw(spaceshipShader); 
-        glm::mat4 thrusterModel2 = glm::mat4(1.0f);
-        thrusterModel2 = glm::translate(thrusterModel2, thrusterPosition2);  
-        thrusterModel2 = glm::scale(thrusterModel2, glm::vec3(0.005f, thrusterLength * pulse, 0.005f));
-        GLuint modelLocThruster2 = glGetUniformLocation(spaceshipShader.getId(), "model");
-        glUniformMatrix4fv(modelLocThruster2, 1, GL_FALSE, &thrusterModel2[0][0]);
-        glUniform3fv(glGetUniformLocation(spaceshipShader.getId(), "thrusterColor"), 1, &thrusterColor[0]);
-        glUniform1i(glGetUniformLocation(spaceshipShader.getId(), "isThruster"), true); 
-        sphere.draw(spaceshipShader); 
-
-        // game stats + settings
-        timeElapsed += deltaTime;  
-        camera.setPosition(camera.getCameraPosition() + horizontalDirection * forwardSpeed * deltaTime);
-        numPlanets = glm::min(90, 45 + 1 * (int)timeElapsed);
-
-        // game over condition
-        if (gameOver == false) {
-            forwardSpeed = glm::min(5000.0f, 50.0f + 25.0f * timeElapsed);  // Cap speed at 1000
-            score += timeElapsed / 1000.0f + forwardSpeed / 500;
-            std::cout << "Score: " << (int)score << " Planets: " << planetPositions.size() << " Speed: " << forwardSpeed << std::endl;
-            if (score < 0.0f)
-                score = 0.0f;
-        }
-        else {
-            forwardSpeed = 25.0f;
-            planetRotationSpeed = 0;
+        glm::vec3 noThrusterColor = glm::vec3(0.0f, 0.0f, 0.0f);
+        world.each<Transform, Renderable>([&](Entity, Transform& transform, Renderable& renderable) {
+            if (renderable.flags & RENDER_INSTANCED)
+                return;
+            bool thruster = (renderable.flags & RENDER_THRUSTER) != 0;
+            glUniformMatrix4fv(spaceshipModelLoc, 1, GL_FALSE, &transform.model[0][0]);
+            glUniform3fv(spaceshipThrusterColorLoc, 1, thruster ? &thrusterColor[0] : &noThrusterColor[0]);
+            glUniform1i(spaceshipIsThrusterLoc, thruster);
+            renderMeshes[renderable.model]->get().draw(*renderMaterials[renderable.model]);
+        });
+
+        // back to the simulated state, the next step continues from there
+        camera.setPosition(simulatedCameraPosition);
+
+        // game stats
+        if (gameOver == false)
+            std::cout << "Score: " << (int)score << " Planets: " << planetCount << " Visible: " << planetCullStats.visible << "/" << planetCullStats.tested << " Speed: " << forwardSpeed << std::endl;
+
+        // how long each system took, once a second
+        if (currentFrame - lastTimingReport > 1.0f) {
+            lastTimingReport = currentFrame;
+            std::cout << "Systems:";
+            const std::vector<SystemTiming>& timings = world.getSystemTimings();
+            for (size_t i = 0; i < timings.size(); ++i)
+                std::cout << " " << timings[i].name << " " << timings[i].milliseconds << " ms";
+            std::cout << std::endl;
         }
         window.update();
     }
@@ -267,7 +427,7 @@ int main()
 
 void processKeyboardInput()
 {
-    float movingSpeed = glm::min(20.0f, 0.2f + 0.1f * timeElapsed);
+    float movingSpeed = glm::min(20.0f, 0.2f + 0.1f * timeElapsed) * simulationStep * 60.0f;    // tuned per frame at 60 fps
     glm::vec3 horizontalDirection = glm::normalize(glm::vec3(camera.getCameraViewDirection().x, 0.0f, camera.getCameraViewDirection().z));
     glm::vec3 rightDirection = glm::normalize(glm::cross(horizontalDirection, camera.getCameraUp()));
 
@@ -285,98 +445,146 @@ void processKeyboardInput()
             camera.setPosition(camera.getCameraPosition() - rightDirection * movingSpeed);
         if (window.isPressed(GLFW_KEY_D))
             camera.setPosition(camera.getCameraPosition() + rightDirection * movingSpeed);
-        if (window.isPressed(GLFW_KEY_SPACE)) {
+        // input is read every simulation step, up to 8 of them a frame, so shots are spaced by simulated time
+        if (window.isPressed(GLFW_KEY_SPACE) && simulationTime >= nextShotTime) {
+            nextShotTime = simulationTime + shotCooldown;
+            // the shot leaves the spaceship along the flight direction and takes out the first planet in its way
             glm::vec3 spaceshipPos = camera.getCameraPosition() + camera.getCameraViewDirection() * 10.0f;
-            for (size_t i = 0; i < planetPositions.size(); ++i) {
-                glm::vec3 planetPos = planetPositions[i];
-                float scale = planetScales[i];
-                AABB planetBox(planetPos, scale * boundingBoxScaleFactor);
-                if (planetBox.intersectsXY(spaceshipPos)) {
-                    score -= 1000.0f;
-                    planetPositions.erase(planetPositions.begin() + i);
-                    planetScales.erase(planetScales.begin() + i);
-                    planetBoundingBoxes.erase(planetBoundingBoxes.begin() + i);
-                    --i; 
-                }
+            RayHit hit;
+            if (planetTree.raycast(spaceshipPos, horizontalDirection, shotRange, hit)) {
+                score -= 1000.0f;
+                removePlanet(world.getEntity(hit.id));
             }
         }
     }
 }
 
-glm::vec3 generateRandomPosition(float rangeMin, float rangeMax) {
-    float x = rangeMin + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (rangeMax - rangeMin)));
-    float y = rangeMin + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (rangeMax - rangeMin)));
-    float z = rangeMin - 3000 + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (rangeMax - rangeMin)));
-    return glm::vec3(x, y, z);
-}
-
-float generateRandomScale(float minScale, float maxScale) {
-    return minScale + static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / (maxScale - minScale)));
-}
-
-AABB getSpaceshipBoundingBox(const glm::mat4& model) {
-    glm::vec3 scale = glm::vec3(model[0][0], model[1][1], model[2][2]); 
-    glm::vec3 spaceshipPos = glm::vec3(model[3]);
-    return AABB(spaceshipPos, scale.x);  
-}
-
+// the spaceship's box is swept from where it was before this step to where it is now, however far it moved
 void checkCollisions() {
-    glm::mat4 spaceshipModel = glm::mat4(1.0f); 
-    spaceshipModel = glm::translate(spaceshipModel, camera.getCameraPosition() + camera.getCameraViewDirection() * 10.0f);
-    spaceshipModel = glm::scale(spaceshipModel, glm::vec3(1.0f, 1.0f, 1.0f));  
-    AABB spaceshipBox = getSpaceshipBoundingBox(spaceshipModel);
-    for (size_t i = 0; i < planetBoundingBoxes.size(); ++i) {
-        if (spaceshipBox.intersects(planetBoundingBoxes[i])) {
+    Transform* spaceship = world.get<Transform>(spaceshipEntity);
+    glm::vec3 halfExtents(world.get<Collider>(spaceshipEntity)->halfExtent);
+    glm::vec3 sweptMin = glm::min(spaceship->previousPosition, spaceship->position) - halfExtents;
+    glm::vec3 sweptMax = glm::max(spaceship->previousPosition, spaceship->position) + halfExtents;
+    static std::vector<unsigned int> hits;
+    hits.clear();
+    planetGrid.query(sweptMin, sweptMax, hits);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        Bounds* planetBox = world.get<Bounds>(world.getEntity(hits[i]));
+        float timeOfImpact;
+        if (planetBox && sweepBox(spaceship->previousPosition, spaceship->position, halfExtents, planetBox->min, planetBox->max, timeOfImpact)) {
             gameOver = true;  
             std::cout << "GAME OVER! Final score: " << score << " Press R to restart! " << std::endl;
+            return;
         }
     }
 }
 
-void generatePlanets(int numPlanets, float rangeMin, float rangeMax, float minScale, float maxScale) {
-    for (int i = 0; i < numPlanets; ++i) {
-        glm::vec3 cameraPos = camera.getCameraPosition();
-        glm::vec3 planetPos = generateRandomPosition(rangeMin, rangeMax);
-        planetPos += cameraPos;
-        planetPositions.push_back(planetPos);
-        float scale = generateRandomScale(minScale, maxScale);
-        planetScales.push_back(scale);
+// planets of a sector, drawn in the same order every time the sector loads
+void loadSector(Sector& sector, SectorRandom& random) {
+    glm::vec3 sectorCenter = (sector.boundsMin + sector.boundsMax) * 0.5f;
+    float crowding = 1.0f + glm::min(1.0f, glm::length(sectorCenter) / sectorRampDistance);
+    unsigned int count = glm::min((unsigned int)MAX_SECTOR_ENTITIES, (unsigned int)(planetsPerSector * crowding + random.nextFloat()));
+    for (unsigned int i = 0; i < count; ++i) {
+        glm::vec3 planetPos(random.range(sector.boundsMin.x, sector.boundsMax.x),
+                            random.range(sector.boundsMin.y, sector.boundsMax.y),
+                            random.range(sector.boundsMin.z, sector.boundsMax.z));
+        float scale = random.range(planetMinScale, planetMaxScale);
+        unsigned int skin = glm::min(planetSkinCount - 1, (unsigned int)(random.nextFloat() * planetSkinCount));
+        if (glm::length(planetPos) < startClearance)
+            continue;
         float boundingBoxScale = scale * boundingBoxScaleFactor;
-        planetBoundingBoxes.push_back(AABB(planetPos, boundingBoxScale));
+        AABB planetBox(planetPos, boundingBoxScale);
+        Transform transform = { planetPos, planetPos, glm::vec3(scale), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, glm::mat4(1.0f) };
+        Rotator rotator = { 1.0f };
+        Collider collider = { boundingBoxScale };
+        Bounds bounds = { planetBox.min, planetBox.max };
+        Renderable renderable = { MODEL_PLANET, RENDER_INSTANCED, skin };
+        Entity planet = world.create(transform, rotator, collider, bounds, renderable);
+        planetGrid.insert(planet.index, planetBox.min, planetBox.max);
+        planetTree.insert(planet.index, planetBox.min, planetBox.max);
+        planetCount++;
+        sector.entities[sector.entityCount++] = planet;
     }
 }
 
+// planets shot down while the sector was loaded are already gone
+void unloadSector(Sector& sector) {
+    for (unsigned int i = 0; i < sector.entityCount; ++i)
+        if (world.isAlive(sector.entities[i]))
+            removePlanet(sector.entities[i]);
+    sector.entityCount = 0;
+}
+
+// sectors load ahead along the flight direction and unload once they fall behind
 void updatePlanets() {
-    glm::vec3 cameraPos = camera.getCameraPosition();
-    if (glm::length(cameraPos - lastCameraPosition) > 800.0f) {
-        generatePlanets(numPlanets, planetRangeMin, planetRangeMax, planetMinScale, planetMaxScale);
-        lastCameraPosition = cameraPos;  
-    }
-    for (int i = 0; i < planetPositions.size(); ++i) {
-        glm::vec3 planetPos = planetPositions[i];
-        glm::vec3 toPlanet = planetPos - cameraPos;
-        float dotProduct = glm::dot(camera.getCameraViewDirection(), toPlanet);
-        if (dotProduct < 0.0f) {
-            planetPositions.erase(planetPositions.begin() + i);
-            planetScales.erase(planetScales.begin() + i);
-            planetBoundingBoxes.erase(planetBoundingBoxes.begin() + i);
-            --i;
-        }
+    glm::vec3 flightDirection = glm::normalize(glm::vec3(camera.getCameraViewDirection().x, 0.0f, camera.getCameraViewDirection().z));
+    sectors.update(camera.getCameraPosition(), flightDirection, loadSector, unloadSector);
+}
+
+void removePlanet(Entity planet) {
+    planetGrid.remove(planet.index);
+    planetTree.remove(planet.index);
+    world.destroy(planet);
+    planetCount--;
+}
+
+// the spaceship flies 10 units in front of the camera, the thrusters flicker behind it
+void updateSpaceship() {
+    thrusterLength += simulationStep * 5.0f; 
+    if (thrusterLength > 0.01f) {
+        thrusterLength = 0.01f;
     }
+    glm::vec3 spaceshipPosition = camera.getCameraPosition() + camera.getCameraViewDirection() * 10.0f;
+    world.get<Transform>(spaceshipEntity)->position = spaceshipPosition;
+
+    float pulse = 0.05f + 0.5f * sin(simulationTime * 5.0f);    // simulated time, so replaying the same steps gives the same flames
+    glm::vec3 thrusterPosition = spaceshipPosition - camera.getCameraRightDirection() * 0.39f - camera.getCameraViewDirection() * 1.5f - camera.getCameraUp() * 0.125f;
+    glm::vec3 thrusterPosition2 = spaceshipPosition + camera.getCameraRightDirection() * 0.39f - camera.getCameraViewDirection() * 1.5f - camera.getCameraUp() * 0.125f; 
+    Transform* thruster = world.get<Transform>(thrusterEntities[0]);
+    thruster->position = thrusterPosition;
+    thruster->scale = glm::vec3(0.005f, thrusterLength * pulse, 0.005f);
+    thruster = world.get<Transform>(thrusterEntities[1]);
+    thruster->position = thrusterPosition2;
+    thruster->scale = glm::vec3(0.005f, thrusterLength * pulse, 0.005f);
 }
 
 void resetGame() {
     gameOver = false;
     camera.setPosition(glm::vec3(0.0f, 5.0f, 20.0f)); 
     camera.setRotation(-15.0f, -90.0f); 
+    previousCameraPosition = camera.getCameraPosition();    // no blending across the jump back to the start
     score = 0.0f;
     planetRotationSpeed = 5.0f;
-    planetPositions.clear();
-    planetScales.clear();
-    planetBoundingBoxes.clear();
-    numPlanets = 45;
-    generatePlanets(numPlanets, planetRangeMin, planetRangeMax, planetMinScale, planetMaxScale);
+    // the same seed again, the next frame streams in the same sectors as the last run
+    sectors.clear(unloadSector);
     timeElapsed = 0.0f;
     forwardSpeed = 50.0f;
     thrusterLength = 0.0f;
+
+    // the spaceship starts over at the start instead of sweeping back there through everything in between
+    updateSpaceship();
+    Entity spaceshipParts[3] = { spaceshipEntity, thrusterEntities[0], thrusterEntities[1] };
+    for (int i = 0; i < 3; ++i) {
+        Transform* transform = world.get<Transform>(spaceshipParts[i]);
+        transform->previousPosition = transform->position;
+    }
+}
+
+// source images named planet* in the directory, in name order so the layers do not change between runs;
+// baked .ktx2 files are picked up beside their sources by the loader
+std::vector<std::string> findPlanetSkins(const std::string& directory) {
+    const std::string extensions[5] = { ".bmp", ".png", ".jpg", ".jpeg", ".tga" };
+    std::vector<std::string> skins;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        std::string extension = it->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (it->path().stem().string().compare(0, 6, "planet") == 0 && std::find(extensions, extensions + 5, extension) != extensions + 5)
+            skins.push_back(it->path().generic_string());
+    }
+    std::sort(skins.begin(), skins.end());
+
+    if (skins.empty())
+        skins.push_back(directory + "/planet2.bmp");
+    return skins;
 }